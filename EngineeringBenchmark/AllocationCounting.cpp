@@ -0,0 +1,163 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Replacement global allocation functions. Every form of operator new is counted, so results can report
+//  allocations per operation, and each is paired with the operator delete forms that release it.
+// These live in their own translation unit so the compiler never sees a replaced delete inlined into code whose
+//  allocations it attributes to the library operator new
+
+std::atomic<uint64_t> g_allocationCount(0);
+
+namespace
+{
+
+void* allocateCounted(size_t size) noexcept
+{
+	g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return malloc(size == 0 ? 1 : size);
+}
+
+} // namespace
+
+void* operator new(size_t size)
+{
+	void* memory = allocateCounted(size);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return allocateCounted(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return allocateCounted(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
+
+#ifdef __cpp_aligned_new
+
+namespace
+{
+
+void* allocateCountedAligned(size_t size, std::align_val_t alignment) noexcept
+{
+	g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	size_t alignmentBytes = (size_t)alignment;
+	// aligned_alloc requires the size to be a non-zero multiple of the alignment
+	size = (size == 0) ? alignmentBytes : (size + alignmentBytes - 1) / alignmentBytes * alignmentBytes;
+#ifdef _WIN32
+	return _aligned_malloc(size, alignmentBytes);
+#else
+	return aligned_alloc(alignmentBytes, size);
+#endif
+}
+
+void freeAligned(void* memory) noexcept
+{
+#ifdef _WIN32
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+}
+
+} // namespace
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* memory = allocateCountedAligned(size, alignment);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocateCountedAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocateCountedAligned(size, alignment);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	freeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+	freeAligned(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+	freeAligned(memory);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+	freeAligned(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	freeAligned(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	freeAligned(memory);
+}
+
+#endif
@@ -0,0 +1,453 @@
+#pragma once
+
+#include "BenchmarkHarness.h"
+
+#include "BallEventSimulator.h"
+#include "BallGameExercise.h"
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+struct BallBenchmarkConfig
+{
+	int queryCount = 4096; // Queries generated per input distribution and timed as one batch
+	int fuzzSampleCount = 1000000; // Queries compared against the high-precision reference per distribution
+	int simulatedBallCount = 10000; // Balls run to the floor by BallEventSimulator per iteration
+	int wallBounceFuzzSampleCount = 100000; // calculateWallBounces queries checked per distribution
+};
+
+enum class TrajectoryDistribution
+{
+	Typical, // Moderate speeds within a 100 unit wide box, including some paths that never reach the height
+	HugeTravel, // Very fast horizontal travel over a long flight, wrapping between the walls many thousands of times
+	NearZeroDiscriminant, // Heights just below the apex, where endVSq is close to zero
+	NegativeTime, // Rising balls starting above the height, so the first root is negative and the second must be used
+	Count
+};
+
+inline const char* getTrajectoryDistributionName(TrajectoryDistribution distribution)
+{
+	switch (distribution)
+	{
+	case TrajectoryDistribution::Typical:
+		return "typical";
+	case TrajectoryDistribution::HugeTravel:
+		return "hugeTravel";
+	case TrajectoryDistribution::NearZeroDiscriminant:
+		return "nearZeroDiscriminant";
+	case TrajectoryDistribution::NegativeTime:
+		return "negativeTime";
+	default:
+		return "unknown";
+	}
+}
+
+struct TrajectoryQuery
+{
+	float h;
+	Vec2 p;
+	Vec2 v;
+	float G;
+	float w;
+};
+
+inline TrajectoryQuery generateTrajectoryQuery(TrajectoryDistribution distribution, std::mt19937& rng)
+{
+	auto uniform = [&rng](float min, float max) { return std::uniform_real_distribution<float>(min, max)(rng); };
+	auto randomSign = [&rng]() { return (rng() & 1) ? 1.0f : -1.0f; };
+
+	TrajectoryQuery query;
+	query.G = -9.807f;
+	query.w = 100.0f;
+	query.p = { uniform(0.0f, query.w), uniform(0.0f, 100.0f) };
+	query.v = { randomSign() * uniform(0.0f, 100.0f), uniform(-50.0f, 50.0f) };
+	query.h = uniform(0.0f, 100.0f);
+
+	switch (distribution)
+	{
+	case TrajectoryDistribution::HugeTravel:
+		query.G = -uniform(0.01f, 0.1f);
+		query.v = { randomSign() * uniform(1.0e4f, 1.0e6f), uniform(0.0f, 50.0f) };
+		query.h = uniform(0.0f, query.p.y);
+		break;
+	case TrajectoryDistribution::NearZeroDiscriminant:
+	{
+		// Rising balls, so the apex is still ahead of them. apex = p.y + v.y^2 / -2G, approached from below by a
+		//  relative margin spanning several orders of magnitude
+		query.v.y = uniform(0.0f, 50.0f);
+		float apex = query.p.y + (query.v.y * query.v.y) / (-2 * query.G);
+		float margin = powf(10.0f, uniform(-9.0f, -3.0f)) * fmaxf(fabsf(apex), 1.0f);
+		query.h = apex - margin;
+		break;
+	}
+	case TrajectoryDistribution::NegativeTime:
+		query.p.y = uniform(50.0f, 100.0f);
+		query.v.y = uniform(1.0f, 50.0f);
+		query.h = uniform(0.0f, query.p.y);
+		break;
+	default:
+		break;
+	}
+	return query;
+}
+
+inline std::vector<TrajectoryQuery> generateTrajectoryQueries(TrajectoryDistribution distribution, int count, unsigned int seed)
+{
+	std::mt19937 rng(seed + (unsigned int)distribution);
+	std::vector<TrajectoryQuery> queries;
+	queries.reserve(count);
+	for (int i = 0; i < count; i++)
+	{
+		queries.push_back(generateTrajectoryQuery(distribution, rng));
+	}
+	return queries;
+}
+
+// High-precision equivalent of reflectValueBetweenBounds, used as the reference for accuracy checks
+inline long double reflectValueBetweenBoundsReference(long double value, long double min, long double max)
+{
+	long double range = max - min;
+	value = fmodl(fabsl(value - min), range * 2);
+	if (value > range)
+	{
+		value = range * 2 - value;
+	}
+	return value + min;
+}
+
+// High-precision reference for tryCalculateXPositionAtHeight: the earliest crossing of h at or after t = 0.
+// Inputs are promoted exactly from float, so any difference is error introduced by the solver under test
+inline bool tryCalculateXPositionAtHeightReference(const TrajectoryQuery& query, long double& xPosition)
+{
+	long double py = query.p.y, vy = query.v.y, G = query.G;
+	long double endVSq = vy * vy + 2 * G * ((long double)query.h - py);
+	if (endVSq < 0)
+	{
+		return false;
+	}
+
+	// Stable roots of (G/2)t^2 + v.y*t + (p.y - h) = 0
+	long double q = -0.5L * (vy + copysignl(sqrtl(endVSq), vy));
+	long double roots[2] = { INFINITY, INFINITY };
+	if (G != 0)
+	{
+		roots[0] = q / (0.5L * G);
+	}
+	if (q != 0)
+	{
+		roots[1] = (py - query.h) / q;
+	}
+	long double earliest = INFINITY;
+	for (long double t : roots)
+	{
+		if (t >= 0 && t < earliest)
+		{
+			earliest = t;
+		}
+	}
+	if (!std::isfinite(earliest))
+	{
+		return false;
+	}
+	xPosition = reflectValueBetweenBoundsReference((long double)query.v.x * earliest + query.p.x, 0, query.w);
+	return true;
+}
+
+struct TrajectoryAccuracy
+{
+	std::string solverName;
+	TrajectoryDistribution distribution;
+	int sampleCount;
+	int comparedCount; // Samples where both the solver and the reference found a crossing
+	int successMismatchCount; // Samples where only one of the solver and the reference found a crossing
+	int nonFiniteCount; // Crossings the solver reported with an infinite or NaN position, excluded from the error
+	double maxError;
+	double meanError;
+	TrajectoryQuery worstQuery;
+};
+
+// Compares a float solver, bool(const TrajectoryQuery&, float&), against the reference across 'sampleCount' fuzzed queries
+template <typename Solver>
+TrajectoryAccuracy measureTrajectoryAccuracy(const char* solverName, TrajectoryDistribution distribution, int sampleCount, unsigned int seed, Solver solver)
+{
+	TrajectoryAccuracy accuracy = {};
+	accuracy.solverName = solverName;
+	accuracy.distribution = distribution;
+	accuracy.sampleCount = sampleCount;
+
+	std::mt19937 rng(seed + (unsigned int)distribution);
+	double totalError = 0;
+	for (int i = 0; i < sampleCount; i++)
+	{
+		TrajectoryQuery query = generateTrajectoryQuery(distribution, rng);
+		float xPosition = 0;
+		long double referenceXPosition = 0;
+		bool success = solver(query, xPosition);
+		bool referenceSuccess = tryCalculateXPositionAtHeightReference(query, referenceXPosition);
+		if (success != referenceSuccess)
+		{
+			accuracy.successMismatchCount++;
+		}
+		else if (success && !std::isfinite(xPosition))
+		{
+			accuracy.nonFiniteCount++;
+		}
+		else if (success)
+		{
+			double error = (double)fabsl(xPosition - referenceXPosition);
+			if (accuracy.comparedCount == 0 || error > accuracy.maxError)
+			{
+				accuracy.maxError = error;
+				accuracy.worstQuery = query;
+			}
+			totalError += error;
+			accuracy.comparedCount++;
+		}
+	}
+	accuracy.meanError = (accuracy.comparedCount > 0) ? totalError / accuracy.comparedCount : 0.0;
+	return accuracy;
+}
+
+struct WallBounceFuzzResult
+{
+	TrajectoryDistribution distribution;
+	int sampleCount;
+	int countMismatchCount; // Samples whose bounce count differs from the reference by more than a bounce at either end
+	int invalidBounceCount; // Samples with a bounce out of time order, outside (0..maxTime] or away from both walls
+	int nonFiniteSampleCount; // Queries made with an infinite or NaN maxTime, which must be rejected
+	int nonFiniteRejectedCount;
+};
+
+// Number of walls the unbounded x position passes in (0..maxTime], in high precision
+inline long double countWallBouncesReference(const TrajectoryQuery& query, float maxTime)
+{
+	long double px = query.p.x, vx = query.v.x, w = query.w;
+	long double endX = px + vx * maxTime;
+	if (vx > 0)
+	{
+		return floorl(endX / w) - floorl(px / w);
+	}
+	if (vx < 0)
+	{
+		return ceill(px / w) - ceill(endX / w);
+	}
+	return 0;
+}
+
+// Lists the bounces of fuzzed balls over horizons of up to 64 wall-to-wall crossings, checking their count, order
+//  and positions, and checks that an infinite or NaN horizon is rejected rather than looping forever
+inline WallBounceFuzzResult measureWallBounceAccuracy(TrajectoryDistribution distribution, int sampleCount, unsigned int seed)
+{
+	WallBounceFuzzResult result = {};
+	result.distribution = distribution;
+	result.sampleCount = sampleCount;
+
+	std::mt19937 rng(seed + (unsigned int)distribution);
+	for (int i = 0; i < sampleCount; i++)
+	{
+		TrajectoryQuery query = generateTrajectoryQuery(distribution, rng);
+		BallTrajectory trajectory(query.p, query.v, query.G, query.w);
+		float crossingTime = (query.v.x != 0) ? query.w / fabsf(query.v.x) : 1.0f;
+		float maxTime = std::uniform_real_distribution<float>(0.0f, 64.0f)(rng) * crossingTime;
+
+		std::vector<WallBounce> bounces = trajectory.calculateWallBounces(maxTime);
+		if (fabsl((long double)bounces.size() - countWallBouncesReference(query, maxTime)) > 1)
+		{
+			result.countMismatchCount++;
+		}
+		float previousTime = 0;
+		for (const auto& bounce : bounces)
+		{
+			float wallDistance = fminf(fabsf(bounce.position.x), fabsf(bounce.position.x - query.w));
+			if (!(bounce.t > previousTime && bounce.t <= maxTime) || wallDistance > 1.0e-3f * query.w)
+			{
+				result.invalidBounceCount++;
+				break;
+			}
+			previousTime = bounce.t;
+		}
+
+		if (i % 16 == 0)
+		{
+			float nonFiniteTime = (i % 32 == 0) ? INFINITY : NAN;
+			result.nonFiniteSampleCount++;
+			try
+			{
+				trajectory.calculateWallBounces(nonFiniteTime);
+			}
+			catch (const std::invalid_argument&)
+			{
+				result.nonFiniteRejectedCount++;
+			}
+		}
+	}
+	return result;
+}
+
+inline BenchmarkResult labelResult(BenchmarkResult result, const std::string& name, const char* itemLabel)
+{
+	result.name = name;
+	result.itemLabel = itemLabel;
+	return result;
+}
+
+inline std::vector<BenchmarkResult> runBallGameBenchmarks(const BenchmarkSettings& settings, const BallBenchmarkConfig& config)
+{
+	std::vector<BenchmarkResult> results;
+
+	for (int i = 0; i < (int)TrajectoryDistribution::Count; i++)
+	{
+		TrajectoryDistribution distribution = (TrajectoryDistribution)i;
+		std::string suffix = std::string(".") + getTrajectoryDistributionName(distribution);
+		const std::vector<TrajectoryQuery> queries = generateTrajectoryQueries(distribution, config.queryCount, settings.seed);
+
+		// Single queries, each solved from scratch
+		BenchmarkResult result = runBenchmark(settings, 1.0, [&]()
+		{
+			uint64_t hits = 0;
+			for (const auto& query : queries)
+			{
+				float xPosition;
+				hits += tryCalculateXPositionAtHeight(query.h, query.p, query.v, query.G, query.w, xPosition) ? 1 : 0;
+			}
+			g_benchmarkSink = hits;
+			return (uint64_t)queries.size();
+		});
+		results.push_back(labelResult(result, "tryCalculateXPositionAtHeight" + suffix, "queries"));
+
+		// Single queries, including the per-ball setup of a BallTrajectory
+		result = runBenchmark(settings, 1.0, [&]()
+		{
+			uint64_t hits = 0;
+			for (const auto& query : queries)
+			{
+				float xPosition;
+				hits += BallTrajectory(query.p, query.v, query.G, query.w).tryCalculateXPositionAtHeight(query.h, xPosition) ? 1 : 0;
+			}
+			g_benchmarkSink = hits;
+			return (uint64_t)queries.size();
+		});
+		results.push_back(labelResult(result, "BallTrajectory.tryCalculateXPositionAtHeight" + suffix, "queries"));
+
+		// Batched queries, every height answered against one ball
+		std::vector<float> heights;
+		for (const auto& query : queries)
+		{
+			heights.push_back(query.h);
+		}
+		std::vector<HeightCrossings> crossings(heights.size());
+		const TrajectoryQuery& ball = queries.front();
+		BallTrajectory trajectory(ball.p, ball.v, ball.G, ball.w);
+		result = runBenchmark(settings, 1.0, [&]()
+		{
+			trajectory.calculateCrossingsAtHeights(heights.data(), heights.size(), crossings.data());
+			g_benchmarkSink = crossings.back().count;
+			return (uint64_t)heights.size();
+		});
+		results.push_back(labelResult(result, "BallTrajectory.calculateCrossingsAtHeights" + suffix, "queries"));
+
+		// Wall reflection of the unbounded x positions each distribution produces at t = 1
+		std::vector<float> unboundedXPositions;
+		for (const auto& query : queries)
+		{
+			unboundedXPositions.push_back(query.v.x + query.p.x);
+		}
+		result = runBenchmark(settings, 1.0, [&]()
+		{
+			float total = 0;
+			for (float value : unboundedXPositions)
+			{
+				total += reflectValueBetweenBounds(value, 0, 100.0f);
+			}
+			g_benchmarkSink = (uint64_t)total;
+			return (uint64_t)unboundedXPositions.size();
+		});
+		results.push_back(labelResult(result, "reflectValueBetweenBounds" + suffix, "values"));
+	}
+
+	// Every typical ball run from launch to the floor, crossing three target lines. The setup of each ball is timed
+	//  as well, as it solves every line crossing up front
+	if (config.simulatedBallCount > 0)
+	{
+		const std::vector<TrajectoryQuery> balls = generateTrajectoryQueries(TrajectoryDistribution::Typical, config.simulatedBallCount, settings.seed);
+		const std::vector<float> targetHeights = { 25.0f, 50.0f, 75.0f };
+		BenchmarkResult result = runBenchmark(settings, 1.0, [&]()
+		{
+			BallEventSimulator simulator(balls.front().G, balls.front().w, 0.0f, targetHeights);
+			for (const auto& ball : balls)
+			{
+				simulator.addBall(ball.p, ball.v);
+			}
+			uint64_t eventCount = 0;
+			simulator.advanceTo(INFINITY, [&eventCount](const BallEvent&) { eventCount++; });
+			return eventCount;
+		});
+		results.push_back(labelResult(result, "BallEventSimulator.advanceTo.typical", "events"));
+	}
+
+	return results;
+}
+
+inline std::vector<TrajectoryAccuracy> runTrajectoryAccuracyFuzz(const BenchmarkSettings& settings, const BallBenchmarkConfig& config)
+{
+	std::vector<TrajectoryAccuracy> accuracies;
+	for (int i = 0; i < (int)TrajectoryDistribution::Count; i++)
+	{
+		TrajectoryDistribution distribution = (TrajectoryDistribution)i;
+		accuracies.push_back(measureTrajectoryAccuracy("tryCalculateXPositionAtHeight", distribution, config.fuzzSampleCount, settings.seed,
+			[](const TrajectoryQuery& query, float& xPosition)
+		{
+			return tryCalculateXPositionAtHeight(query.h, query.p, query.v, query.G, query.w, xPosition);
+		}));
+		accuracies.push_back(measureTrajectoryAccuracy("BallTrajectory.tryCalculateXPositionAtHeight", distribution, config.fuzzSampleCount, settings.seed,
+			[](const TrajectoryQuery& query, float& xPosition)
+		{
+			return BallTrajectory(query.p, query.v, query.G, query.w).tryCalculateXPositionAtHeight(query.h, xPosition);
+		}));
+	}
+	return accuracies;
+}
+
+inline std::vector<WallBounceFuzzResult> runWallBounceFuzz(const BenchmarkSettings& settings, const BallBenchmarkConfig& config)
+{
+	std::vector<WallBounceFuzzResult> results;
+	for (int i = 0; i < (int)TrajectoryDistribution::Count; i++)
+	{
+		results.push_back(measureWallBounceAccuracy((TrajectoryDistribution)i, config.wallBounceFuzzSampleCount, settings.seed));
+	}
+	return results;
+}
+
+inline void printBallBenchmarkResultsAsJson(const BenchmarkSettings& settings, const std::vector<BenchmarkResult>& results, const std::vector<TrajectoryAccuracy>& accuracies,
+	const std::vector<WallBounceFuzzResult>& wallBounces)
+{
+	printf("{\n");
+	printBenchmarkSettingsAsJson("ball", settings);
+	printf("  \"results\": [");
+	printBenchmarkResultEntriesAsJson(results);
+	printf("\n  ],\n");
+	printf("  \"accuracy\": [");
+	for (size_t i = 0; i < accuracies.size(); i++)
+	{
+		const auto& accuracy = accuracies[i];
+		const auto& worst = accuracy.worstQuery;
+		printf("%s\n    {", (i == 0) ? "" : ",");
+		printf("\"solver\": \"%s\", \"distribution\": \"%s\", ", accuracy.solverName.c_str(), getTrajectoryDistributionName(accuracy.distribution));
+		printf("\"samples\": %d, \"compared\": %d, \"successMismatches\": %d, \"nonFinite\": %d, ", accuracy.sampleCount, accuracy.comparedCount, accuracy.successMismatchCount, accuracy.nonFiniteCount);
+		printf("\"maxError\": %.9g, \"meanError\": %.9g, ", accuracy.maxError, accuracy.meanError);
+		printf("\"worst\": {\"h\": %.9g, \"p\": [%.9g, %.9g], \"v\": [%.9g, %.9g], \"G\": %.9g, \"w\": %.9g}}",
+			worst.h, worst.p.x, worst.p.y, worst.v.x, worst.v.y, worst.G, worst.w);
+	}
+	printf("\n  ],\n");
+	printf("  \"wallBounces\": [");
+	for (size_t i = 0; i < wallBounces.size(); i++)
+	{
+		const auto& wallBounce = wallBounces[i];
+		printf("%s\n    {", (i == 0) ? "" : ",");
+		printf("\"distribution\": \"%s\", \"samples\": %d, \"countMismatches\": %d, \"invalidBounces\": %d, ", getTrajectoryDistributionName(wallBounce.distribution),
+			wallBounce.sampleCount, wallBounce.countMismatchCount, wallBounce.invalidBounceCount);
+		printf("\"nonFiniteSamples\": %d, \"nonFiniteRejected\": %d}", wallBounce.nonFiniteSampleCount, wallBounce.nonFiniteRejectedCount);
+	}
+	printf("\n  ]\n}\n");
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Incremented by the replacement global operator new overloads in AllocationCounting.cpp
+extern std::atomic<uint64_t> g_allocationCount;
+
+using BenchmarkClock = std::chrono::steady_clock;
+
+struct BenchmarkSettings
+{
+	unsigned int seed = 1;
+	int warmupIterations = 1;
+	double minTimeS = 0.25; // Keep iterating until at least this much time has been measured
+	uint64_t maxIterations = 1000000;
+};
+
+struct BenchmarkResult
+{
+	std::string name;
+	std::string itemLabel; // Unit used for throughput, e.g. "cells" or "moves"
+	int width;
+	int height;
+	int colorCount;
+	uint64_t iterations;
+	uint64_t operations;
+	double nsPerOp;
+	double allocationsPerOp;
+	double itemsPerSecond;
+};
+
+// Outcome of checking an optimized path against its reference, such as replaying a recording bit for bit
+struct BenchmarkVerification
+{
+	std::string name;
+	uint64_t checked;
+	uint64_t mismatches;
+};
+
+// Prevents the optimizer from discarding results of the benchmarked functions
+static volatile uint64_t g_benchmarkSink;
+
+// Runs 'operation' repeatedly until the minimum time has elapsed, after discarding the warm-up iterations.
+// 'operation' returns the number of logical operations performed by a single call, allowing one call
+//  to cover a batch (such as every move on a board) without timing each entry individually
+template <typename Operation>
+BenchmarkResult runBenchmark(const BenchmarkSettings& settings, double itemsPerOperation, Operation operation)
+{
+	for (int i = 0; i < settings.warmupIterations; i++)
+	{
+		g_benchmarkSink = operation();
+	}
+
+	BenchmarkResult result = {};
+	uint64_t allocationsBefore = g_allocationCount.load(std::memory_order_relaxed);
+	BenchmarkClock::duration elapsed = BenchmarkClock::duration::zero();
+	auto minTime = std::chrono::duration_cast<BenchmarkClock::duration>(std::chrono::duration<double>(settings.minTimeS));
+	while ((elapsed < minTime || result.iterations == 0) && result.iterations < settings.maxIterations)
+	{
+		auto start = BenchmarkClock::now();
+		uint64_t operations = operation();
+		elapsed += BenchmarkClock::now() - start;
+		result.operations += operations;
+		result.iterations++;
+	}
+	uint64_t allocations = g_allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+
+	double elapsedNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+	double operationCount = (result.operations > 0) ? (double)result.operations : 1.0;
+	result.nsPerOp = elapsedNs / operationCount;
+	result.allocationsPerOp = (double)allocations / operationCount;
+	result.itemsPerSecond = (elapsedNs > 0) ? (itemsPerOperation * (double)result.operations) / (elapsedNs * 1e-9) : 0.0;
+	return result;
+}
+
+// Writes the "results" array body, one object per line, without the surrounding brackets
+inline void printBenchmarkResultEntriesAsJson(const std::vector<BenchmarkResult>& results)
+{
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const auto& result = results[i];
+		printf("%s\n    {", (i == 0) ? "" : ",");
+		printf("\"name\": \"%s\", \"width\": %d, \"height\": %d, \"colors\": %d, ", result.name.c_str(), result.width, result.height, result.colorCount);
+		printf("\"iterations\": %llu, \"operations\": %llu, ", (unsigned long long)result.iterations, (unsigned long long)result.operations);
+		printf("\"nsPerOp\": %.3f, \"allocationsPerOp\": %.3f, ", result.nsPerOp, result.allocationsPerOp);
+		printf("\"throughput\": %.3f, \"throughputUnit\": \"%s/s\"}", result.itemsPerSecond, result.itemLabel.c_str());
+	}
+}
+
+inline void printBenchmarkSettingsAsJson(const char* suiteName, const BenchmarkSettings& settings)
+{
+	printf("  \"suite\": \"%s\",\n", suiteName);
+	printf("  \"seed\": %u,\n", settings.seed);
+	printf("  \"warmupIterations\": %d,\n", settings.warmupIterations);
+	printf("  \"minTimeS\": %g,\n", settings.minTimeS);
+}
+
+inline void printBenchmarkResultsAsJson(const char* suiteName, const BenchmarkSettings& settings, const std::vector<BenchmarkResult>& results)
+{
+	printf("{\n");
+	printBenchmarkSettingsAsJson(suiteName, settings);
+	printf("  \"results\": [");
+	printBenchmarkResultEntriesAsJson(results);
+	printf("\n  ]\n}\n");
+}
+
+// As above, followed by a "verification" array listing the cases checked and mismatches found for each
+inline void printBenchmarkResultsAsJson(const char* suiteName, const BenchmarkSettings& settings, const std::vector<BenchmarkResult>& results,
+	const std::vector<BenchmarkVerification>& verifications)
+{
+	printf("{\n");
+	printBenchmarkSettingsAsJson(suiteName, settings);
+	printf("  \"results\": [");
+	printBenchmarkResultEntriesAsJson(results);
+	printf("\n  ],\n");
+	printf("  \"verification\": [");
+	for (size_t i = 0; i < verifications.size(); i++)
+	{
+		const auto& verification = verifications[i];
+		printf("%s\n    {\"name\": \"%s\", \"checked\": %llu, \"mismatches\": %llu}", (i == 0) ? "" : ",",
+			verification.name.c_str(), (unsigned long long)verification.checked, (unsigned long long)verification.mismatches);
+	}
+	printf("\n  ]\n}\n");
+}
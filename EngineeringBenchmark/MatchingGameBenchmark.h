@@ -0,0 +1,380 @@
+#pragma once
+
+#include "BenchmarkHarness.h"
+
+#include "MatchingGameCache.h"
+#include "MatchingGameExercise.h"
+#include "MatchingGameRanking.h"
+#include "MatchingGameScoring.h"
+#include "MatchingGameSearch.h"
+#include "MatchingGameSimulator.h"
+
+#include <cstdlib>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+struct MatchingBenchmarkConfig
+{
+	std::vector<int> boardSizes = { 8, 16, 32, 64, 128, 256 };
+	std::vector<int> colorCounts = { 4, 5, 7 };
+	int maxFullSearchSize = 32; // Largest board size to run calculateMovesForBoard against, as a full search grows rapidly with area
+	int searchBoardCount = 4; // Boards per size and color count checked against MoveSearchService
+	std::vector<int> scanSizes = { 1024 }; // Board sizes beyond the sweep on which only the full cascade scan is timed
+};
+
+// Fills every cell with a random jewel, without avoiding matches as beginGame does, so a scan finds many groups
+inline Board generateBoardWithMatches(int size, int colorCount, unsigned int seed)
+{
+	Board board(size, size);
+	srand(seed);
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			board.setJewel(x, y, (JewelKind)(1 + rand() % colorCount));
+		}
+	}
+	return board;
+}
+
+// Every swap calculateMovesForBoard considers for a board
+inline std::vector<Move> enumerateCandidateMoves(const Board& board)
+{
+	std::vector<Move> moves;
+	for (int y = 0; y < board.getHeight(); y++)
+	{
+		for (int x = 0; x < board.getWidth(); x++)
+		{
+			if (y < board.getHeight() - 1)
+			{
+				moves.push_back({ x, y, MoveDirection::Up });
+			}
+			if (x < board.getWidth() - 1)
+			{
+				moves.push_back({ x, y, MoveDirection::Right });
+			}
+		}
+	}
+	return moves;
+}
+
+inline BenchmarkResult labelResult(BenchmarkResult result, const char* name, const char* itemLabel, int size, int colorCount)
+{
+	result.name = name;
+	result.itemLabel = itemLabel;
+	result.width = size;
+	result.height = size;
+	result.colorCount = colorCount;
+	return result;
+}
+
+inline std::vector<BenchmarkResult> runMatchingGameBenchmarks(const BenchmarkSettings& settings, const MatchingBenchmarkConfig& config)
+{
+	std::vector<BenchmarkResult> results;
+	MatchingGameExercise matchingGame;
+
+	for (int size : config.boardSizes)
+	{
+		for (int colorCount : config.colorCounts)
+		{
+			double cellCount = (double)size * size;
+
+			// Board generation, reseeded each call so every iteration produces the same board
+			BenchmarkResult result = runBenchmark(settings, cellCount, [&]()
+			{
+				srand(settings.seed);
+				Board generatedBoard = matchingGame.beginGame(size, size, colorCount);
+				g_benchmarkSink = generatedBoard.getJewel(0, 0);
+				return (uint64_t)1;
+			});
+			results.push_back(labelResult(result, "beginGame", "cells", size, colorCount));
+
+			srand(settings.seed);
+			const Board board = matchingGame.beginGame(size, size, colorCount);
+			const std::vector<Move> moves = enumerateCandidateMoves(board);
+
+			// Match detection for every candidate swap; the swap itself is applied and reverted in place
+			Board workingBoard = board;
+			result = runBenchmark(settings, 1.0, [&]()
+			{
+				uint64_t matchedGroups = 0;
+				for (const auto& move : moves)
+				{
+					performMoveForBoard(move, workingBoard);
+					matchedGroups += findMatchesAfterMoveForBoard(move, workingBoard).size();
+					performMoveForBoard(move, workingBoard);
+				}
+				g_benchmarkSink = matchedGroups;
+				return (uint64_t)moves.size();
+			});
+			results.push_back(labelResult(result, "findMatchesAfterMoveForBoard", "moves", size, colorCount));
+
+			// Full board scan for cascades. Generated boards contain no matches, so this measures the scan cost alone
+			result = runBenchmark(settings, cellCount, [&]()
+			{
+				g_benchmarkSink = resolveCascadingMatches(workingBoard).size();
+				return (uint64_t)1;
+			});
+			results.push_back(labelResult(result, "resolveCascadingMatches", "cells", size, colorCount));
+
+			if (size <= config.maxFullSearchSize)
+			{
+				result = runBenchmark(settings, (double)moves.size(), [&]()
+				{
+					g_benchmarkSink = matchingGame.calculateMovesForBoard(board).size();
+					return (uint64_t)1;
+				});
+				results.push_back(labelResult(result, "calculateMovesForBoard", "moves", size, colorCount));
+
+				result = runBenchmark(settings, (double)moves.size(), [&]()
+				{
+					try
+					{
+						g_benchmarkSink = matchingGame.calculateBestMoveForBoard(board).x;
+					}
+					catch (const std::logic_error&)
+					{
+						g_benchmarkSink = 0; // No scoring move exists for this board
+					}
+					return (uint64_t)1;
+				});
+				results.push_back(labelResult(result, "calculateBestMoveForBoard", "moves", size, colorCount));
+
+				// Repeated queries for the same board, answered from the cache after the first (warm-up) call
+				MatchingGameExercise cachedGame;
+				cachedGame.setRankedMovesCache(std::make_shared<RankedMovesCache>(64));
+				result = runBenchmark(settings, (double)moves.size(), [&]()
+				{
+					g_benchmarkSink = cachedGame.findOrCalculateMovesForBoard(board)->size();
+					return (uint64_t)1;
+				});
+				results.push_back(labelResult(result, "findOrCalculateMovesForBoard.cached", "moves", size, colorCount));
+			}
+		}
+	}
+
+	// Full cascade scans of large boards, both without matches and with a match in most neighbourhoods
+	for (int size : config.scanSizes)
+	{
+		for (int colorCount : config.colorCounts)
+		{
+			double cellCount = (double)size * size;
+			srand(settings.seed);
+			Board board = matchingGame.beginGame(size, size, colorCount);
+			BenchmarkResult result = runBenchmark(settings, cellCount, [&]()
+			{
+				g_benchmarkSink = resolveCascadingMatches(board).size();
+				return (uint64_t)1;
+			});
+			results.push_back(labelResult(result, "resolveCascadingMatches", "cells", size, colorCount));
+
+			board = generateBoardWithMatches(size, colorCount, settings.seed);
+			result = runBenchmark(settings, cellCount, [&]()
+			{
+				g_benchmarkSink = resolveCascadingMatches(board).size();
+				return (uint64_t)1;
+			});
+			results.push_back(labelResult(result, "resolveCascadingMatches.randomFill", "cells", size, colorCount));
+		}
+	}
+
+	return results;
+}
+
+inline bool isSameMove(const Move& lhs, const Move& rhs)
+{
+	return lhs.x == rhs.x && lhs.y == rhs.y && lhs.direction == rhs.direction;
+}
+
+// Checks a search result against the best of the first movesEvaluated candidates, found by stopping calculateTopMovesForBoard
+//  at that point. A completed search reports every candidate, so this also covers the full search
+inline bool isConsistentSearchResult(const Board& board, const MoveSearchResult& result)
+{
+	if (result.movesEvaluated <= 0)
+	{
+		return !result.foundMove;
+	}
+	int movesVisited = 0;
+	TopRankedMoves<1> expected = calculateTopMovesForBoard<1>(board, [&movesVisited, &result](const TopRankedMoves<1>&, bool)
+	{
+		return ++movesVisited < result.movesEvaluated;
+	});
+	if (expected.empty())
+	{
+		return !result.foundMove;
+	}
+	return result.foundMove && isSameMove(result.bestMove, expected.getBest().move) && result.bestScore == expected.getBest().score;
+}
+
+// True if the top K moves are the first K of the full ranking, taken from the highest score down and in traversal
+//  order within a score, so the same move must win each tie
+template <size_t K>
+inline bool isTopOfRanking(const TopRankedMoves<K>& topMoves, const RankedMoves& ranking)
+{
+	std::vector<ScoredMove> expected;
+	for (auto entry = ranking.rbegin(); entry != ranking.rend() && expected.size() < K; ++entry)
+	{
+		for (size_t i = 0; i < entry->second.size() && expected.size() < K; i++)
+		{
+			expected.push_back({ entry->first, 0, entry->second[i] });
+		}
+	}
+
+	std::vector<ScoredMove> sortedMoves = topMoves.getSortedMoves();
+	if (sortedMoves.size() != expected.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < expected.size(); i++)
+	{
+		if (sortedMoves[i].score != expected[i].score || !isSameMove(sortedMoves[i].move, expected[i].move))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Compares calculateTopMovesForBoard under a scoring policy against the full calculateMovesForBoard ranking under the
+//  same policy, keeping both the single best move and the top five
+template <typename ScoringPolicy>
+inline void verifyTopMovesForPolicy(const char* policyName, const std::vector<Board>& boards, std::vector<BenchmarkVerification>& out_verifications)
+{
+	MatchingGameExercise matchingGame;
+	BenchmarkVerification bestMove = { std::string("calculateTopMovesForBoard.") + policyName + ".top1", 0, 0 };
+	BenchmarkVerification topMoves = { std::string("calculateTopMovesForBoard.") + policyName + ".top5", 0, 0 };
+	for (const auto& board : boards)
+	{
+		RankedMoves ranking = matchingGame.calculateMovesForBoard<ScoringPolicy>(board);
+		bestMove.checked++;
+		if (!isTopOfRanking(calculateTopMovesForBoard<1, ScoringPolicy>(board), ranking))
+		{
+			bestMove.mismatches++;
+		}
+		topMoves.checked++;
+		if (!isTopOfRanking(calculateTopMovesForBoard<5, ScoringPolicy>(board), ranking))
+		{
+			topMoves.mismatches++;
+		}
+	}
+	out_verifications.push_back(bestMove);
+	out_verifications.push_back(topMoves);
+}
+
+// Runs three searches per board on a MoveSearchService: one left to complete, one cancelled from its first improvement,
+//  and one whose deadline passes while its first improvement is being reported. Each is compared against calculateBestMoveForBoard.
+// Then checks calculateTopMovesForBoard against the full ranking under each scoring policy
+inline std::vector<BenchmarkVerification> runMatchingVerification(const BenchmarkSettings& settings, const MatchingBenchmarkConfig& config)
+{
+	BenchmarkVerification completed = { "MoveSearchJob.completed", 0, 0 };
+	BenchmarkVerification cancelled = { "MoveSearchJob.cancelled", 0, 0 };
+	BenchmarkVerification deadlineExpired = { "MoveSearchJob.deadlineExpired", 0, 0 };
+	MatchingGameExercise matchingGame;
+	MoveSearchService service(2);
+
+	for (int size : config.boardSizes)
+	{
+		if (size > config.maxFullSearchSize)
+		{
+			continue;
+		}
+		for (int colorCount : config.colorCounts)
+		{
+			for (int boardIndex = 0; boardIndex < config.searchBoardCount; boardIndex++)
+			{
+				srand(settings.seed + boardIndex);
+				const Board board = matchingGame.beginGame(size, size, colorCount);
+				bool hasBestMove = true;
+				Move bestMove = {};
+				try
+				{
+					bestMove = matchingGame.calculateBestMoveForBoard(board);
+				}
+				catch (const std::logic_error&)
+				{
+					hasBestMove = false; // No scoring move exists, so no search can be stopped by an improvement
+				}
+
+				// Left to run, the search must find the same move as calculateBestMoveForBoard
+				MoveSearchResult result = service.submit(board)->wait();
+				completed.checked++;
+				if (result.foundMove != hasBestMove || (hasBestMove && !isSameMove(result.bestMove, bestMove))
+					|| result.movesEvaluated != result.movesTotal || !isConsistentSearchResult(board, result))
+				{
+					completed.mismatches++;
+				}
+
+				// The callback may run before submit returns, so it waits for the job handle before cancelling
+				std::promise<MoveSearchJob*> cancelledJobPromise;
+				std::shared_future<MoveSearchJob*> cancelledJob = cancelledJobPromise.get_future().share();
+				std::shared_ptr<MoveSearchJob> job = service.submit(board, [cancelledJob](const MoveSearchResult&)
+				{
+					cancelledJob.get()->cancel();
+				});
+				cancelledJobPromise.set_value(job.get());
+				result = job->wait();
+				cancelled.checked++;
+				MoveSearchStatus expectedStatus = hasBestMove ? MoveSearchStatus::Cancelled : MoveSearchStatus::Completed;
+				if (job->getStatus() != expectedStatus || (hasBestMove && result.movesEvaluated >= result.movesTotal) || !isConsistentSearchResult(board, result))
+				{
+					cancelled.mismatches++;
+				}
+
+				// The callback holds up the search until its deadline has passed
+				MoveSearchClock::time_point deadline = MoveSearchClock::now() + std::chrono::milliseconds(20);
+				job = service.submit(board, deadline, [deadline](const MoveSearchResult&)
+				{
+					std::this_thread::sleep_until(deadline + std::chrono::milliseconds(1));
+				});
+				result = job->wait();
+				deadlineExpired.checked++;
+				expectedStatus = hasBestMove ? MoveSearchStatus::DeadlineExpired : MoveSearchStatus::Completed;
+				if (job->getStatus() != expectedStatus || (hasBestMove && result.movesEvaluated >= result.movesTotal) || !isConsistentSearchResult(board, result))
+				{
+					deadlineExpired.mismatches++;
+				}
+			}
+		}
+	}
+
+	std::vector<BenchmarkVerification> verifications = { completed, cancelled, deadlineExpired };
+
+	// Each scoring policy is checked on generated boards, and on random-filled boards that already hold matches
+	std::vector<Board> rankingBoards;
+	for (int size : config.boardSizes)
+	{
+		if (size > config.maxFullSearchSize)
+		{
+			continue;
+		}
+		for (int colorCount : config.colorCounts)
+		{
+			for (int boardIndex = 0; boardIndex < config.searchBoardCount; boardIndex++)
+			{
+				srand(settings.seed + boardIndex);
+				rankingBoards.push_back(matchingGame.beginGame(size, size, colorCount));
+				rankingBoards.push_back(generateBoardWithMatches(size, colorCount, settings.seed + boardIndex));
+			}
+		}
+	}
+	verifyTopMovesForPolicy<UniqueCellScoringPolicy>("UniqueCell", rankingBoards, verifications);
+	verifyTopMovesForPolicy<CascadeMultiplierScoringPolicy>("CascadeMultiplier", rankingBoards, verifications);
+	verifyTopMovesForPolicy<MatchLengthBonusScoringPolicy<2>>("MatchLengthBonus2", rankingBoards, verifications);
+	verifyTopMovesForPolicy<SpecialJewelScoringPolicy<Red, 3>>("SpecialJewelRed3", rankingBoards, verifications);
+
+	return verifications;
+}
+
+inline void printSimulationStatsAsJson(const SimulationConfig& config, const SimulationStats& stats)
+{
+	printf("{\n");
+	printf("  \"suite\": \"simulation\",\n");
+	printf("  \"seed\": %u,\n", config.seed);
+	printf("  \"width\": %d, \"height\": %d, \"colors\": %d, \"threads\": %u,\n", config.boardWidth, config.boardHeight, config.colorCount, config.threadCount);
+	printf("  \"games\": %d, \"totalMoves\": %lld, \"totalScore\": %lld,\n", stats.gamesPlayed, stats.totalMoves, stats.totalScore);
+	printf("  \"minScore\": %d, \"maxScore\": %d, \"meanScore\": %.3f, \"meanMovesPerGame\": %.3f,\n", stats.minScore, stats.maxScore, stats.meanScore, stats.meanMovesPerGame);
+	printf("  \"meanCascadeDepth\": %.3f, \"maxCascadeDepth\": %d,\n", stats.meanCascadeDepth, stats.maxCascadeDepth);
+	printf("  \"elapsedS\": %.3f, \"movesPerSecond\": %.3f, \"gamesPerSecond\": %.3f\n", stats.elapsedS, stats.movesPerSecond, stats.gamesPerSecond);
+	printf("}\n");
+}
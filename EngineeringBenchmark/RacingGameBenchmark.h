@@ -0,0 +1,520 @@
+#pragma once
+
+#include "BenchmarkHarness.h"
+
+#include "RacerCollisionBatch.h"
+#include "RacerRegistry.h"
+#include "RacerTickRecording.h"
+#include "RacerUpdateScheduler.h"
+#include "RacingGameExercise.h"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+
+struct RacingBenchmarkConfig
+{
+	std::vector<int> racerCounts = { 100, 1000 };
+	int recordedTickCount = 600; // Ticks of updateRacersV2 recorded, then replayed through each update strategy
+};
+
+// Distinct racer types for RacerRegistry, sharing the behaviour of the stub Racer
+struct RegistryCarRacer : Racer {};
+struct RegistryTruckRacer : Racer {};
+using BenchmarkRacerRegistry = RacerRegistry<RegistryCarRacer, RegistryTruckRacer>;
+
+// Racer that records each call to update and collidesWith in a shared log, so that two strategies can be checked to
+//  make the same calls in the same order. Whether a racer is collidable, and which pairs collide, follow from their
+//  ids, so that some racers explode on every tick
+struct InstrumentedRacer : Racer
+{
+	enum CallKind : uint64_t
+	{
+		Update = 1,
+		CollidesWith = 2
+	};
+
+	InstrumentedRacer(int id, std::vector<uint64_t>* log) :
+		id(id),
+		log(log)
+	{
+	}
+
+	bool isCollidable() const { return id % 7 != 3; }
+
+	void update(float)
+	{
+		log->push_back((Update << 62) | (uint64_t)id);
+	}
+
+	bool collidesWith(const InstrumentedRacer* other) const
+	{
+		log->push_back((CollidesWith << 62) | ((uint64_t)id << 31) | (uint64_t)other->id);
+		return ((id * 2654435761u) ^ (other->id * 40503u)) % 4001 == 0;
+	}
+
+	int id;
+	std::vector<uint64_t>* log;
+};
+
+struct InstrumentedCarRacer : InstrumentedRacer
+{
+	using InstrumentedRacer::InstrumentedRacer;
+};
+
+struct InstrumentedTruckRacer : InstrumentedRacer
+{
+	using InstrumentedRacer::InstrumentedRacer;
+};
+
+// Counters shared by WorkloadRacers, so verification can see how often and how recently each racer was updated
+struct WorkloadRacerTracker
+{
+	unsigned int tick;
+	uint64_t updateCount;
+	uint64_t staleCollisionTests; // Pairs tested while either racer had not been updated on the current tick
+};
+
+// Racer whose update stands in for the physics and AI of a real racer, so that the work saved by deferring updates
+//  can be measured. It never collides, so the same collection can be run for as many ticks as needed
+struct WorkloadRacer : Racer
+{
+	static const int SubstepCount = 256;
+
+	explicit WorkloadRacer(WorkloadRacerTracker* tracker = nullptr) :
+		tracker(tracker),
+		position(1.0f),
+		velocity(0.0f),
+		elapsedMS(0.0f),
+		lastUpdatedTick((unsigned int)-1)
+	{
+	}
+
+	void update(float deltaTimeMS)
+	{
+		// Integrates a spring in fixed substeps of the time received
+		float stepS = deltaTimeMS * (0.001f / SubstepCount);
+		for (int i = 0; i < SubstepCount; i++)
+		{
+			velocity -= position * stepS;
+			position += velocity * stepS;
+		}
+		elapsedMS += deltaTimeMS;
+		if (tracker != nullptr)
+		{
+			tracker->updateCount++;
+			lastUpdatedTick = tracker->tick;
+		}
+	}
+
+	bool collidesWith(const WorkloadRacer* other) const
+	{
+		if (tracker != nullptr && (lastUpdatedTick != tracker->tick || other->lastUpdatedTick != tracker->tick))
+		{
+			tracker->staleCollisionTests++;
+		}
+		return false;
+	}
+
+	WorkloadRacerTracker* tracker;
+	float position;
+	float velocity;
+	float elapsedMS; // Total time received through update
+	unsigned int lastUpdatedTick;
+};
+
+inline std::vector<WorkloadRacer*> createWorkloadRacers(int racerCount, WorkloadRacerTracker* tracker = nullptr)
+{
+	std::vector<WorkloadRacer*> racers;
+	for (int i = 0; i < racerCount; i++)
+	{
+		racers.push_back(new WorkloadRacer(tracker));
+	}
+	return racers;
+}
+
+inline BenchmarkResult labelRacingResult(BenchmarkResult result, const char* name, int racerCount, const char* itemLabel = "racers")
+{
+	result.name = std::string(name) + "." + std::to_string(racerCount);
+	result.itemLabel = itemLabel;
+	return result;
+}
+
+// Random shapes of a single kind spread through a 100 unit cube, so that a small share of all pairs overlap
+inline RacerCollisionShapes generateRacerShapes(int racerCount, RacerShapeKind kind, unsigned int seed)
+{
+	std::mt19937 rng(seed + (unsigned int)kind);
+	auto uniform = [&rng](float min, float max) { return std::uniform_real_distribution<float>(min, max)(rng); };
+
+	RacerCollisionShapes shapes;
+	shapes.resize(racerCount);
+	for (int i = 0; i < racerCount; i++)
+	{
+		float x = uniform(0.0f, 100.0f);
+		float y = uniform(0.0f, 100.0f);
+		float z = uniform(0.0f, 100.0f);
+		if (kind == RacerShapeKind::Sphere)
+		{
+			shapes.setSphere(i, x, y, z, uniform(0.5f, 4.0f));
+		}
+		else if (kind == RacerShapeKind::Box)
+		{
+			shapes.setBox(i, x, y, z, uniform(0.5f, 4.0f), uniform(0.5f, 4.0f), uniform(0.5f, 4.0f));
+		}
+	}
+	return shapes;
+}
+
+// Splits the racers evenly between the registered types, grouped by type
+inline void populateRacerRegistry(int racerCount, BenchmarkRacerRegistry& out_registry)
+{
+	for (int i = 0; i < racerCount; i++)
+	{
+		if (i < racerCount / 2)
+		{
+			out_registry.add<RegistryCarRacer>();
+		}
+		else
+		{
+			out_registry.add<RegistryTruckRacer>();
+		}
+	}
+}
+
+// Racers left after a tick are deleted, so every iteration starts from a freshly created collection
+template <typename RacerType>
+inline void deleteRacers(std::vector<RacerType*>& racers, const std::function<void(Racer*)>& onRacerDeleted = nullptr)
+{
+	for (auto* racer : racers)
+	{
+		if (onRacerDeleted)
+		{
+			onRacerDeleted(racer);
+		}
+		delete racer;
+	}
+	racers.clear();
+}
+
+// Indices of the racers removed by a collision pass, such as resolveRacerCollisions, in the order they were removed
+template <typename Resolve>
+std::vector<int> recordRacerRemovalOrder(int racerCount, Resolve resolve)
+{
+	std::vector<Racer*> racers = createRacerCollection(racerCount);
+	std::unordered_map<const Racer*, int> racerIndices;
+	for (int i = 0; i < racerCount; i++)
+	{
+		racerIndices[racers[i]] = i;
+	}
+	std::vector<int> removalOrder;
+	resolve(racers, [&](Racer* racer) { removalOrder.push_back(racerIndices[racer]); });
+	deleteRacers(racers);
+	return removalOrder;
+}
+
+inline std::vector<BenchmarkResult> runRacingGameBenchmarks(const BenchmarkSettings& settings, const RacingBenchmarkConfig& config)
+{
+	std::vector<BenchmarkResult> results;
+	const float updateTick = 1.0f / 60.0f;
+
+	for (int racerCount : config.racerCounts)
+	{
+		// A single tick over a new collection, including creating the racers. Every stub racer collides with every other,
+		//  so each tick also removes the whole collection
+		BenchmarkResult result = runBenchmark(settings, (double)racerCount, [&]()
+		{
+			std::vector<Racer*> racers = createRacerCollection(racerCount);
+			updateRacersV2(updateTick, racers);
+			deleteRacers(racers);
+			return (uint64_t)1;
+		});
+		results.push_back(labelRacingResult(result, "updateRacersV2", racerCount));
+
+		// As above through the scheduler, with every racer placed in the lowest of three tiers. Stub racers do no work in
+		//  update, so this measures the scheduling overhead on top of updateRacersV2
+		RacerUpdateScheduler scheduler({ 1, 2, 4 }, [](const Racer&) { return 2; });
+		result = runBenchmark(settings, (double)racerCount, [&]()
+		{
+			std::vector<Racer*> racers = createRacerCollection(racerCount);
+			scheduler.update(updateTick, racers);
+			deleteRacers(racers, [&scheduler](Racer* racer) { scheduler.forgetRacer(racer); });
+			return (uint64_t)1;
+		});
+		results.push_back(labelRacingResult(result, "RacerUpdateScheduler.update", racerCount));
+
+		// Steady ticks over a collection of WorkloadRacers, which do real work in update and never collide. The
+		//  scheduler, with every racer in the lowest of three tiers, updates a quarter of them each tick
+		std::vector<WorkloadRacer*> workloadRacers = createWorkloadRacers(racerCount);
+		result = runBenchmark(settings, (double)racerCount, [&]()
+		{
+			updateLiveRacers(updateTick, workloadRacers);
+			resolveRacerCollisions(workloadRacers);
+			return (uint64_t)1;
+		});
+		results.push_back(labelRacingResult(result, "updateRacersV2.workload", racerCount));
+
+		RacerUpdateScheduler workloadScheduler({ 1, 2, 4 }, [](const Racer&) { return 2; });
+		result = runBenchmark(settings, (double)racerCount, [&]()
+		{
+			workloadScheduler.update(updateTick, workloadRacers);
+			return (uint64_t)1;
+		});
+		results.push_back(labelRacingResult(result, "RacerUpdateScheduler.update.workload", racerCount));
+		deleteRacers(workloadRacers);
+
+		// As above with racers stored by value in a registry of two types
+		result = runBenchmark(settings, (double)racerCount, [&]()
+		{
+			BenchmarkRacerRegistry registry;
+			populateRacerRegistry(racerCount, registry);
+			updateRacersV2(updateTick, registry);
+			return (uint64_t)1;
+		});
+		results.push_back(labelRacingResult(result, "RacerRegistry.update", racerCount));
+
+		// Narrowphase over every pair of racers, with the scalar sphere test as the baseline for the batched kernels
+		std::vector<RacerPair> allPairs;
+		buildAllRacerPairs(racerCount, allPairs);
+		std::vector<Racer*> racers = createRacerCollection(racerCount);
+		RacerNarrowphase narrowphase;
+		std::vector<RacerPair> collidingPairs;
+
+		const RacerCollisionShapes spheres = generateRacerShapes(racerCount, RacerShapeKind::Sphere, settings.seed);
+		result = runBenchmark(settings, (double)allPairs.size(), [&]()
+		{
+			uint64_t collisions = 0;
+			for (const auto& pair : allPairs)
+			{
+				collisions += RacerCollisionKernels::testSpherePair(spheres, pair) ? 1 : 0;
+			}
+			g_benchmarkSink = collisions;
+			return (uint64_t)1;
+		});
+		results.push_back(labelRacingResult(result, "testSpherePair.scalar", racerCount, "pairs"));
+
+		result = runBenchmark(settings, (double)allPairs.size(), [&]()
+		{
+			narrowphase.findCollidingPairs(racers, spheres, allPairs, collidingPairs);
+			g_benchmarkSink = collidingPairs.size();
+			return (uint64_t)1;
+		});
+		results.push_back(labelRacingResult(result, "RacerNarrowphase.findCollidingPairs.spheres", racerCount, "pairs"));
+
+		const RacerCollisionShapes boxes = generateRacerShapes(racerCount, RacerShapeKind::Box, settings.seed);
+		result = runBenchmark(settings, (double)allPairs.size(), [&]()
+		{
+			narrowphase.findCollidingPairs(racers, boxes, allPairs, collidingPairs);
+			g_benchmarkSink = collidingPairs.size();
+			return (uint64_t)1;
+		});
+		results.push_back(labelRacingResult(result, "RacerNarrowphase.findCollidingPairs.boxes", racerCount, "pairs"));
+		deleteRacers(racers);
+	}
+
+	return results;
+}
+
+// Compares a batched collision kernel against its scalar test for every pair
+template <typename BatchKernel, typename ScalarTest>
+BenchmarkVerification verifyCollisionKernel(const char* name, const RacerCollisionShapes& shapes, const std::vector<RacerPair>& pairs, BatchKernel batchKernel, ScalarTest scalarTest)
+{
+	std::vector<uint64_t> mask;
+	resizeCollisionMask(pairs.size(), mask);
+	batchKernel(shapes, pairs.data(), pairs.size(), mask.data());
+
+	BenchmarkVerification verification = { std::string(name) + ".simd" + std::to_string(RACER_COLLISION_SIMD_WIDTH) + "." + std::to_string(shapes.kinds.size()), pairs.size(), 0 };
+	for (size_t i = 0; i < pairs.size(); i++)
+	{
+		verification.mismatches += (isPairColliding(mask, i) != scalarTest(shapes, pairs[i])) ? 1 : 0;
+	}
+	return verification;
+}
+
+// Runs a two-type registry and updateLiveRacers with resolveRacerCollisions over the same racers concatenated in
+//  type order, for several ticks. Both must call update and collidesWith in the same order and leave the same racers
+inline BenchmarkVerification verifyRegistryCallOrder(int racerCount, float updateTick, int tickCount)
+{
+	std::vector<uint64_t> referenceLog;
+	std::vector<InstrumentedRacer*> referenceRacers;
+	for (int i = 0; i < racerCount; i++)
+	{
+		referenceRacers.push_back(new InstrumentedRacer(i, &referenceLog));
+	}
+
+	std::vector<uint64_t> registryLog;
+	RacerRegistry<InstrumentedCarRacer, InstrumentedTruckRacer> registry;
+	for (int i = 0; i < racerCount; i++)
+	{
+		if (i < racerCount / 2)
+		{
+			registry.add<InstrumentedCarRacer>(i, &registryLog);
+		}
+		else
+		{
+			registry.add<InstrumentedTruckRacer>(i, &registryLog);
+		}
+	}
+
+	for (int tick = 0; tick < tickCount; tick++)
+	{
+		updateLiveRacers(updateTick, referenceRacers);
+		resolveRacerCollisions(referenceRacers);
+		registry.update(updateTick);
+	}
+
+	BenchmarkVerification verification = { "RacerRegistry.callOrder." + std::to_string(racerCount), std::max(referenceLog.size(), registryLog.size()), 0 };
+	for (size_t i = 0; i < verification.checked; i++)
+	{
+		bool matches = (i < referenceLog.size() && i < registryLog.size() && referenceLog[i] == registryLog[i]);
+		verification.mismatches += matches ? 0 : 1;
+	}
+
+	std::vector<int> remainingIds;
+	for (const auto& racer : registry.getBatch<InstrumentedCarRacer>())
+	{
+		remainingIds.push_back(racer.id);
+	}
+	for (const auto& racer : registry.getBatch<InstrumentedTruckRacer>())
+	{
+		remainingIds.push_back(racer.id);
+	}
+	verification.checked += referenceRacers.size();
+	for (size_t i = 0; i < referenceRacers.size(); i++)
+	{
+		verification.mismatches += (i < remainingIds.size() && remainingIds[i] == referenceRacers[i]->id) ? 0 : 1;
+	}
+	verification.mismatches += (remainingIds.size() > referenceRacers.size()) ? remainingIds.size() - referenceRacers.size() : 0;
+	deleteRacers(referenceRacers);
+	return verification;
+}
+
+// Runs WorkloadRacers spread across three tiers through a scheduler capped at a quarter of the racers per tick. Each
+//  tick must call update no more often than the cap, and every racer must have received all but a bounded share of
+//  the elapsed time: the cap serves the collection once every four ticks, on top of the longest tier interval
+inline BenchmarkVerification verifySchedulerBudget(int racerCount, float updateTick, int tickCount)
+{
+	const size_t maxUpdatesPerTick = std::max(racerCount / 4, 1);
+	WorkloadRacerTracker tracker = {};
+	std::vector<WorkloadRacer*> racers = createWorkloadRacers(racerCount, &tracker);
+	std::unordered_map<const Racer*, int> tiers;
+	for (int i = 0; i < racerCount; i++)
+	{
+		tiers[racers[i]] = i % 3;
+	}
+	RacerUpdateScheduler scheduler({ 1, 2, 4 }, [&tiers](const Racer& racer) { return tiers[&racer]; }, maxUpdatesPerTick);
+
+	BenchmarkVerification verification = { "RacerUpdateScheduler.budget." + std::to_string(racerCount), 0, 0 };
+	for (int tick = 0; tick < tickCount; tick++)
+	{
+		tracker.tick = tick;
+		uint64_t updatesBefore = tracker.updateCount;
+		scheduler.update(updateTick, racers);
+		verification.checked++;
+		verification.mismatches += (tracker.updateCount - updatesBefore > maxUpdatesPerTick) ? 1 : 0;
+	}
+
+	float elapsedMS = tickCount * updateTick * 1000.0f;
+	float maxPendingMS = (float)(racerCount / maxUpdatesPerTick + 4) * updateTick * 1000.0f;
+	for (const auto* racer : racers)
+	{
+		verification.checked++;
+		verification.mismatches += (racer->elapsedMS < elapsedMS - maxPendingMS - 0.01f || racer->elapsedMS > elapsedMS + 0.01f) ? 1 : 0;
+	}
+	deleteRacers(racers, [&scheduler](Racer* racer) { scheduler.forgetRacer(racer); });
+	return verification;
+}
+
+// Runs WorkloadRacers in the lowest of three tiers through a scheduler whose pair selector asks for every pair to be
+//  brought up to date, so no pair may be tested against a racer that was not updated this tick
+inline BenchmarkVerification verifySchedulerCatchUp(int racerCount, float updateTick, int tickCount)
+{
+	WorkloadRacerTracker tracker = {};
+	std::vector<WorkloadRacer*> racers = createWorkloadRacers(racerCount, &tracker);
+	RacerUpdateScheduler scheduler({ 1, 2, 4 }, [](const Racer&) { return 2; }, 0, [](const Racer&, const Racer&) { return true; });
+	for (int tick = 0; tick < tickCount; tick++)
+	{
+		tracker.tick = tick;
+		scheduler.update(updateTick, racers);
+	}
+	uint64_t pairsTested = (uint64_t)tickCount * racerCount * (racerCount - 1) / 2;
+	deleteRacers(racers, [&scheduler](Racer* racer) { scheduler.forgetRacer(racer); });
+	return BenchmarkVerification{ "RacerUpdateScheduler.catchUp." + std::to_string(racerCount), pairsTested, tracker.staleCollisionTests };
+}
+
+// Each optimized path is checked against its reference:
+//  - The SSE2 or AVX collision kernels against their scalar tests, over every pair of randomly placed shapes.
+//  - resolveRacerCollisionsBatched against resolveRacerCollisions, comparing the order racers are removed in.
+//  - RacerRegistry against the phases of updateRacersV2, comparing every update and collidesWith call and the racers left.
+//  - Replays of a recorded session of updateRacersV2 ticks through each update strategy, which must reproduce every
+//    recorded racer count and state hash.
+//  - RacerUpdateScheduler's update budget, and its pair selector bringing both racers up to date before a test
+inline std::vector<BenchmarkVerification> runRacingVerification(const BenchmarkSettings& settings, const RacingBenchmarkConfig& config)
+{
+	std::vector<BenchmarkVerification> verifications;
+	const float updateTick = 1.0f / 60.0f;
+	// updateRacersV2 is also overloaded for RacerRegistry, so it cannot be passed by name where a function object is expected
+	const RacerUpdateFunction updateRacerCollection = [](float deltaTimeS, std::vector<Racer*>& racers) { updateRacersV2(deltaTimeS, racers); };
+
+	for (int racerCount : config.racerCounts)
+	{
+		std::vector<RacerPair> allPairs;
+		buildAllRacerPairs(racerCount, allPairs);
+		verifications.push_back(verifyCollisionKernel("testSpherePairs", generateRacerShapes(racerCount, RacerShapeKind::Sphere, settings.seed), allPairs,
+			testSpherePairs, RacerCollisionKernels::testSpherePair));
+		verifications.push_back(verifyCollisionKernel("testBoxPairs", generateRacerShapes(racerCount, RacerShapeKind::Box, settings.seed), allPairs,
+			testBoxPairs, RacerCollisionKernels::testBoxPair));
+
+		// Custom shapes fall back to Racer::collidesWith, so both paths test exactly the same pairs
+		std::vector<int> scalarOrder = recordRacerRemovalOrder(racerCount, [](std::vector<Racer*>& racers, const std::function<void(Racer*)>& onRacerRemoved)
+		{
+			resolveRacerCollisions(racers, onRacerRemoved);
+		});
+		std::vector<int> batchedOrder = recordRacerRemovalOrder(racerCount, [&allPairs, racerCount](std::vector<Racer*>& racers, const std::function<void(Racer*)>& onRacerRemoved)
+		{
+			RacerCollisionShapes shapes;
+			shapes.resize(racerCount);
+			RacerNarrowphase narrowphase;
+			resolveRacerCollisionsBatched(racers, shapes, allPairs, narrowphase, onRacerRemoved);
+		});
+		BenchmarkVerification verification = { "resolveRacerCollisionsBatched." + std::to_string(racerCount), std::max(scalarOrder.size(), batchedOrder.size()), 0 };
+		for (size_t i = 0; i < verification.checked; i++)
+		{
+			bool matches = (i < scalarOrder.size() && i < batchedOrder.size() && scalarOrder[i] == batchedOrder[i]);
+			verification.mismatches += matches ? 0 : 1;
+		}
+		verifications.push_back(verification);
+
+		verifications.push_back(verifyRegistryCallOrder(racerCount, updateTick, 3));
+
+		std::vector<Racer*> racers = createRacerCollection(racerCount);
+		RacerTickRecorder recorder(120);
+		recorder.beginRecording(racers);
+		for (int tick = 0; tick < config.recordedTickCount; tick++)
+		{
+			recorder.runAndRecordTick(updateTick, racers, updateRacerCollection);
+		}
+		deleteRacers(racers);
+
+		RacerTickReplay replay;
+		if (!replay.load(recorder.getData()))
+		{
+			verifications.push_back(BenchmarkVerification{ "RacerTickReplay.load." + std::to_string(racerCount), 1, 1 });
+			continue;
+		}
+
+		ReplaySummary summary = replay.replay(0, replay.getTickCount(), updateRacerCollection);
+		verifications.push_back(BenchmarkVerification{ "RacerTickReplay.updateRacersV2." + std::to_string(racerCount), summary.ticksMeasured, summary.mismatchedTicks });
+
+		RacerUpdateScheduler scheduler({ 1, 2, 4 }, [](const Racer&) { return 2; });
+		summary = replay.replay(0, replay.getTickCount(), [&scheduler](float deltaTimeS, std::vector<Racer*>& replayRacers)
+		{
+			scheduler.update(deltaTimeS, replayRacers);
+		});
+		verifications.push_back(BenchmarkVerification{ "RacerTickReplay.RacerUpdateScheduler." + std::to_string(racerCount), summary.ticksMeasured, summary.mismatchedTicks });
+
+		verifications.push_back(verifySchedulerBudget(racerCount, updateTick, 120));
+		verifications.push_back(verifySchedulerCatchUp(racerCount, updateTick, 8));
+	}
+
+	return verifications;
+}
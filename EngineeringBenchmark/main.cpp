@@ -0,0 +1,177 @@
+#include "BallGameBenchmark.h"
+#include "BenchmarkHarness.h"
+#include "MatchingGameBenchmark.h"
+#include "RacingGameBenchmark.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+
+std::vector<int> parseIntegerList(const char* text)
+{
+	std::vector<int> values;
+	std::stringstream stream(text);
+	std::string entry;
+	while (std::getline(stream, entry, ','))
+	{
+		values.push_back(atoi(entry.c_str()));
+	}
+	return values;
+}
+
+void printUsage()
+{
+	fprintf(stderr, "Usage: EngineeringBenchmark [options]\n");
+	fprintf(stderr, "  --suite NAME          Benchmark suite to run: matching (default), ball or racing\n");
+	fprintf(stderr, "  --sizes 8,16,32       Square board sizes to sweep\n");
+	fprintf(stderr, "  --colors 4,5,7        Jewel color counts to sweep (3 to 7)\n");
+	fprintf(stderr, "  --max-search-size N   Skip calculateMovesForBoard for boards larger than N\n");
+	fprintf(stderr, "  --scan-sizes 1024     Larger board sizes on which only the full cascade scan is timed\n");
+	fprintf(stderr, "  --seed N              Seed used to generate every board\n");
+	fprintf(stderr, "  --warmup N            Untimed iterations before measuring\n");
+	fprintf(stderr, "  --min-time S          Minimum measured time per benchmark, in seconds\n");
+	fprintf(stderr, "  --queries N           Trajectory queries per input distribution for the ball suite\n");
+	fprintf(stderr, "  --fuzz-samples N      Trajectory queries checked against the high-precision reference per distribution\n");
+	fprintf(stderr, "  --balls N             Balls simulated to the floor by BallEventSimulator for the ball suite\n");
+	fprintf(stderr, "  --bounce-samples N    calculateWallBounces queries checked per distribution for the ball suite\n");
+	fprintf(stderr, "  --racers 100,1000     Racer collection sizes to sweep for the racing suite\n");
+	fprintf(stderr, "  --recorded-ticks N    Ticks recorded and replayed to verify each racing update strategy\n");
+	fprintf(stderr, "  --simulate-games N    Play N complete games instead of running the microbenchmarks\n");
+	fprintf(stderr, "  --simulate-size N     Square board size for simulated games\n");
+	fprintf(stderr, "  --simulate-colors N   Jewel color count for simulated games\n");
+	fprintf(stderr, "  --threads N           Worker threads for simulated games, zero for all hardware threads\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	BenchmarkSettings settings;
+	MatchingBenchmarkConfig matchingConfig;
+	BallBenchmarkConfig ballConfig;
+	RacingBenchmarkConfig racingConfig;
+	std::string suiteName = "matching";
+	SimulationConfig simulationConfig;
+	simulationConfig.gameCount = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = (i + 1 < argc);
+		if (strcmp(argv[i], "--suite") == 0 && hasValue)
+		{
+			suiteName = argv[++i];
+		}
+		else if (strcmp(argv[i], "--sizes") == 0 && hasValue)
+		{
+			matchingConfig.boardSizes = parseIntegerList(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--colors") == 0 && hasValue)
+		{
+			matchingConfig.colorCounts = parseIntegerList(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--max-search-size") == 0 && hasValue)
+		{
+			matchingConfig.maxFullSearchSize = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--scan-sizes") == 0 && hasValue)
+		{
+			matchingConfig.scanSizes = parseIntegerList(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && hasValue)
+		{
+			settings.seed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--warmup") == 0 && hasValue)
+		{
+			settings.warmupIterations = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--min-time") == 0 && hasValue)
+		{
+			settings.minTimeS = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--queries") == 0 && hasValue)
+		{
+			ballConfig.queryCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--fuzz-samples") == 0 && hasValue)
+		{
+			ballConfig.fuzzSampleCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--balls") == 0 && hasValue)
+		{
+			ballConfig.simulatedBallCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--bounce-samples") == 0 && hasValue)
+		{
+			ballConfig.wallBounceFuzzSampleCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--racers") == 0 && hasValue)
+		{
+			racingConfig.racerCounts = parseIntegerList(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--recorded-ticks") == 0 && hasValue)
+		{
+			racingConfig.recordedTickCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--simulate-games") == 0 && hasValue)
+		{
+			simulationConfig.gameCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--simulate-size") == 0 && hasValue)
+		{
+			simulationConfig.boardWidth = simulationConfig.boardHeight = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--simulate-colors") == 0 && hasValue)
+		{
+			simulationConfig.colorCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+		{
+			simulationConfig.threadCount = (unsigned int)strtoul(argv[++i], nullptr, 10);
+		}
+		else
+		{
+			printUsage();
+			return 1;
+		}
+	}
+
+	// Results are written to stdout as JSON; progress and errors go to stderr
+	if (simulationConfig.gameCount > 0)
+	{
+		simulationConfig.seed = settings.seed;
+		MatchingGameSimulator simulator(simulationConfig);
+		SimulationStats stats = simulator.run();
+		printSimulationStatsAsJson(simulationConfig, stats);
+		return 0;
+	}
+
+	if (suiteName == "ball")
+	{
+		std::vector<BenchmarkResult> results = runBallGameBenchmarks(settings, ballConfig);
+		std::vector<TrajectoryAccuracy> accuracies = runTrajectoryAccuracyFuzz(settings, ballConfig);
+		std::vector<WallBounceFuzzResult> wallBounces = runWallBounceFuzz(settings, ballConfig);
+		printBallBenchmarkResultsAsJson(settings, results, accuracies, wallBounces);
+		return 0;
+	}
+	else if (suiteName == "racing")
+	{
+		std::vector<BenchmarkResult> results = runRacingGameBenchmarks(settings, racingConfig);
+		std::vector<BenchmarkVerification> verifications = runRacingVerification(settings, racingConfig);
+		printBenchmarkResultsAsJson("racing", settings, results, verifications);
+		return 0;
+	}
+	else if (suiteName != "matching")
+	{
+		printUsage();
+		return 1;
+	}
+
+	std::vector<BenchmarkResult> results = runMatchingGameBenchmarks(settings, matchingConfig);
+	std::vector<BenchmarkVerification> verifications = runMatchingVerification(settings, matchingConfig);
+	printBenchmarkResultsAsJson("matching", settings, results, verifications);
+	return 0;
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "BallGameExercise.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <vector>
+
+enum class BallEventKind
+{
+	WallBounce,
+	TargetLineCrossing,
+	FloorHit
+};
+
+struct BallEvent
+{
+	float t;
+	int ballIndex;
+	BallEventKind kind;
+	int targetLineIndex; // Only valid for TargetLineCrossing events
+	Vec2 position;
+};
+
+// Simulates many balls between walls at [0..w] by jumping directly from one event to the next.
+// Each ball follows the closed-form BallTrajectory, so only its next event is held in a priority queue
+//  and the cost scales with the number of events rather than frame rate multiplied by ball count.
+// A ball is removed from the simulation when it falls through the floor height
+class BallEventSimulator
+{
+public:
+	BallEventSimulator(float G, float w, float floorHeight, const std::vector<float>& targetHeights) :
+		m_G(G),
+		m_w(w),
+		m_floorHeight(floorHeight),
+		m_targetHeights(targetHeights),
+		m_currentTime(0)
+	{
+	}
+
+	// Adds a ball at the current simulation time, returning its index
+	int addBall(Vec2 p, Vec2 v)
+	{
+		int ballIndex = (int)m_balls.size();
+		m_balls.push_back(Ball(BallTrajectory(p, v, m_G, m_w), m_currentTime));
+		Ball& ball = m_balls.back();
+
+		HeightCrossings floorCrossings = ball.trajectory.calculateCrossingsAtHeight(m_floorHeight);
+		for (int i = 0; i < floorCrossings.count; i++)
+		{
+			if (!floorCrossings.crossings[i].isRising)
+			{
+				ball.floorTime = floorCrossings.crossings[i].t;
+				break;
+			}
+		}
+
+		// Every line crossing is known up front from the closed form; they are stored in time order and consumed as events
+		for (int lineIndex = 0; lineIndex < (int)m_targetHeights.size(); lineIndex++)
+		{
+			HeightCrossings crossings = ball.trajectory.calculateCrossingsAtHeight(m_targetHeights[lineIndex]);
+			for (int i = 0; i < crossings.count; i++)
+			{
+				if (crossings.crossings[i].t <= ball.floorTime)
+				{
+					ball.lineCrossings.push_back(LineCrossing{ crossings.crossings[i].t, lineIndex });
+				}
+			}
+		}
+		std::sort(ball.lineCrossings.begin(), ball.lineCrossings.end(), [](const LineCrossing& lhs, const LineCrossing& rhs)
+		{
+			return lhs.t < rhs.t || (lhs.t == rhs.t && lhs.lineIndex < rhs.lineIndex);
+		});
+
+		ball.nextWallBounceTime = ball.trajectory.calculateNextWallBounceTime(0);
+		scheduleNextEvent(ballIndex);
+		return ballIndex;
+	}
+
+	// Processes every event up to and including 'time' in time order, passing each to the handler
+	void advanceTo(float time, const std::function<void(const BallEvent&)>& handler)
+	{
+		while (!m_eventQueue.empty() && m_eventQueue.top().t <= time)
+		{
+			ScheduledEvent scheduled = m_eventQueue.top();
+			m_eventQueue.pop();
+
+			Ball& ball = m_balls[scheduled.ballIndex];
+			float localTime = scheduled.t - ball.startTime;
+			BallEvent event;
+			event.t = scheduled.t;
+			event.ballIndex = scheduled.ballIndex;
+			event.kind = scheduled.kind;
+			event.targetLineIndex = -1;
+			event.position = ball.trajectory.getPositionAtTime(localTime);
+
+			switch (scheduled.kind)
+			{
+			case BallEventKind::WallBounce:
+				ball.nextWallBounceTime = ball.trajectory.calculateNextWallBounceTime(localTime);
+				break;
+			case BallEventKind::TargetLineCrossing:
+				event.targetLineIndex = ball.lineCrossings[ball.nextLineCrossing].lineIndex;
+				event.position.y = m_targetHeights[event.targetLineIndex]; // Report the exact line rather than the evaluated height
+				ball.nextLineCrossing++;
+				break;
+			case BallEventKind::FloorHit:
+				event.position.y = m_floorHeight;
+				ball.isActive = false;
+				break;
+			}
+
+			handler(event);
+			if (ball.isActive)
+			{
+				scheduleNextEvent(scheduled.ballIndex);
+			}
+		}
+		m_currentTime = std::max(m_currentTime, time);
+	}
+
+	// Closed-form position of a ball at any time after it was added; no stepping is required
+	Vec2 getBallPosition(int ballIndex, float time) const
+	{
+		const Ball& ball = m_balls[ballIndex];
+		return ball.trajectory.getPositionAtTime(time - ball.startTime);
+	}
+
+	bool isBallActive(int ballIndex) const { return m_balls[ballIndex].isActive; }
+	size_t getBallCount() const { return m_balls.size(); }
+	size_t getPendingEventCount() const { return m_eventQueue.size(); }
+	float getCurrentTime() const { return m_currentTime; }
+
+private:
+	struct LineCrossing
+	{
+		float t;
+		int lineIndex;
+	};
+
+	struct Ball
+	{
+		Ball(const BallTrajectory& newTrajectory, float newStartTime) :
+			trajectory(newTrajectory),
+			startTime(newStartTime),
+			floorTime(INFINITY),
+			nextWallBounceTime(INFINITY),
+			nextLineCrossing(0),
+			isActive(true)
+		{
+		}
+
+		BallTrajectory trajectory;
+		float startTime;
+		float floorTime; // Times are local to the ball, measured from startTime
+		float nextWallBounceTime;
+		std::vector<LineCrossing> lineCrossings;
+		size_t nextLineCrossing;
+		bool isActive;
+	};
+
+	struct ScheduledEvent
+	{
+		float t;
+		int ballIndex;
+		BallEventKind kind;
+
+		// Orders the queue by earliest time first; ties resolve by ball index, then event kind
+		bool operator > (const ScheduledEvent& other) const
+		{
+			if (t != other.t) return t > other.t;
+			if (ballIndex != other.ballIndex) return ballIndex > other.ballIndex;
+			return kind > other.kind;
+		}
+	};
+
+	// Queues only the earliest upcoming event for a ball; the next is scheduled when it is processed
+	void scheduleNextEvent(int ballIndex)
+	{
+		const Ball& ball = m_balls[ballIndex];
+		ScheduledEvent next = { ball.floorTime, ballIndex, BallEventKind::FloorHit };
+		if (ball.nextLineCrossing < ball.lineCrossings.size() && ball.lineCrossings[ball.nextLineCrossing].t <= next.t)
+		{
+			next.t = ball.lineCrossings[ball.nextLineCrossing].t;
+			next.kind = BallEventKind::TargetLineCrossing;
+		}
+		if (ball.nextWallBounceTime < next.t)
+		{
+			next.t = ball.nextWallBounceTime;
+			next.kind = BallEventKind::WallBounce;
+		}
+
+		if (next.t != INFINITY)
+		{
+			next.t += ball.startTime;
+			m_eventQueue.push(next);
+		}
+	}
+
+	float m_G;
+	float m_w;
+	float m_floorHeight;
+	std::vector<float> m_targetHeights;
+	float m_currentTime;
+	std::vector<Ball> m_balls;
+	std::priority_queue<ScheduledEvent, std::vector<ScheduledEvent>, std::greater<ScheduledEvent>> m_eventQueue;
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <math.h>
+#include <stdexcept>
+#include <vector>
 
 struct Vec2
 {
@@ -47,3 +49,172 @@ inline bool tryCalculateXPositionAtHeight(float h, Vec2 p, Vec2 v, float G, floa
 	}
 	return success;
 }
+
+struct HeightCrossing
+{
+	float t;
+	float x;
+	bool isRising; // True if the ball is moving upwards as it crosses the height
+};
+
+// Up to two crossings of a single height, earliest first
+struct HeightCrossings
+{
+	int count;
+	HeightCrossing crossings[2];
+};
+
+struct WallBounce
+{
+	float t;
+	Vec2 position;
+};
+
+// Closed-form path of a ball from starting point p with velocity v, under vertical acceleration G, bouncing
+//  losslessly between walls at [0..w]. Per-ball terms are derived once, so any number of height and
+//  wall-bounce queries can be answered against the same ball without repeating the setup
+class BallTrajectory
+{
+public:
+	BallTrajectory(Vec2 p, Vec2 v, float G, float w) :
+		m_p(p),
+		m_v(v),
+		m_halfG(0.5f * G),
+		m_w(w),
+		m_vySq(v.y * v.y),
+		m_twoG(2 * G)
+	{
+	}
+
+	Vec2 getPositionAtTime(float t) const
+	{
+		Vec2 position;
+		position.x = reflectValueBetweenBounds(m_v.x * t + m_p.x, 0, m_w);
+		position.y = m_p.y + (m_v.y + m_halfG * t) * t;
+		return position;
+	}
+
+	// Finds every crossing of height h at or after t = 0, in time order
+	HeightCrossings calculateCrossingsAtHeight(float h) const
+	{
+		HeightCrossings result;
+		result.count = 0;
+
+		// Roots of (G/2)t^2 + v.y*t + (p.y - h) = 0. The discriminant is the v^2 = u^2 + 2as term from tryCalculateXPositionAtHeight
+		float c = m_p.y - h;
+		float endVSq = m_vySq + m_twoG * (h - m_p.y);
+		if (endVSq < 0)
+		{
+			return result;
+		}
+
+		// Numerically stable form, avoiding cancellation between v.y and the root of the discriminant
+		float q = -0.5f * (m_v.y + copysignf(sqrtf(endVSq), m_v.y));
+		float roots[2] = { INFINITY, INFINITY };
+		int rootCount = 0;
+		if (m_halfG != 0)
+		{
+			roots[rootCount++] = q / m_halfG;
+		}
+		if (q != 0)
+		{
+			roots[rootCount++] = c / q;
+		}
+		if (rootCount == 2 && roots[1] < roots[0])
+		{
+			float earlier = roots[1];
+			roots[1] = roots[0];
+			roots[0] = earlier;
+		}
+
+		for (int i = 0; i < rootCount; i++)
+		{
+			float t = roots[i];
+			if (t >= 0 && !(result.count == 1 && result.crossings[0].t == t))
+			{
+				HeightCrossing& crossing = result.crossings[result.count++];
+				crossing.t = t;
+				crossing.x = reflectValueBetweenBounds(m_v.x * t + m_p.x, 0, m_w);
+				crossing.isRising = (m_v.y + 2 * m_halfG * t) > 0;
+			}
+		}
+		return result;
+	}
+
+	// Equivalent of tryCalculateXPositionAtHeight, restricted to the earliest crossing at or after t = 0
+	bool tryCalculateXPositionAtHeight(float h, float& xPosition) const
+	{
+		HeightCrossings crossings = calculateCrossingsAtHeight(h);
+		if (crossings.count > 0)
+		{
+			xPosition = crossings.crossings[0].x;
+		}
+		return crossings.count > 0;
+	}
+
+	void calculateCrossingsAtHeights(const float* heights, size_t count, HeightCrossings* out_crossings) const
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			out_crossings[i] = calculateCrossingsAtHeight(heights[i]);
+		}
+	}
+
+	// Time of the first wall bounce strictly after 'afterTime', or INFINITY if the ball never reaches a wall
+	float calculateNextWallBounceTime(float afterTime) const
+	{
+		if (m_v.x == 0 || m_w <= 0)
+		{
+			return INFINITY;
+		}
+
+		// Unbounded x meets a wall at every multiple of w; even multiples reflect off the left wall and odd off the right
+		float unboundedX = m_v.x * afterTime + m_p.x;
+		float wallIndex = (m_v.x > 0) ? floorf(unboundedX / m_w) + 1 : ceilf(unboundedX / m_w) - 1;
+		float t = (wallIndex * m_w - m_p.x) / m_v.x;
+		if (t <= afterTime)
+		{
+			// Rounding placed the previous wall back at afterTime; step on to the next one
+			wallIndex += (m_v.x > 0) ? 1 : -1;
+			t = (wallIndex * m_w - m_p.x) / m_v.x;
+		}
+		return t;
+	}
+
+	// Lists every wall bounce in (0..maxTime], in time order. Throws std::invalid_argument unless maxTime is finite,
+	//  as a ball moving sideways bounces without end
+	std::vector<WallBounce> calculateWallBounces(float maxTime) const
+	{
+		if (!isfinite(maxTime))
+		{
+			throw std::invalid_argument("Wall bounces can only be listed up to a finite time");
+		}
+
+		std::vector<WallBounce> bounces;
+		float t = calculateNextWallBounceTime(0);
+		while (t <= maxTime)
+		{
+			WallBounce bounce;
+			bounce.t = t;
+			bounce.position = getPositionAtTime(t);
+			bounces.push_back(bounce);
+
+			float nextT = calculateNextWallBounceTime(t);
+			if (nextT <= t)
+			{
+				// Past the precision of t, later bounces can no longer be told apart
+				break;
+			}
+			t = nextT;
+		}
+		return bounces;
+	}
+
+private:
+	Vec2 m_p;
+	Vec2 m_v;
+	float m_halfG;
+	float m_w;
+	float m_vySq;
+	float m_twoG;
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Monotonic arena for short-lived matching containers. Allocation bumps a pointer, individual
+//  deallocation is a no-op and memory is reclaimed at once by rewind() or reset()
+class MatchingArena
+{
+public:
+	// Position in the arena, returned by getMarker() so that everything allocated after it can be released together
+	struct Marker
+	{
+		size_t chunkCount;
+		size_t offset;
+	};
+
+	// maxRetainedCapacity bounds the memory kept once the arena is reset, so that a single large board does not
+	//  hold on to its peak usage for the lifetime of the thread
+	explicit MatchingArena(size_t initialCapacity = 64 * 1024, size_t maxRetainedCapacity = 16 * 1024 * 1024) :
+		m_offset(0),
+		m_chunkCapacity(initialCapacity),
+		m_totalCapacity(0),
+		m_maxRetainedCapacity(std::max(initialCapacity, maxRetainedCapacity))
+	{
+		addChunk(initialCapacity);
+	}
+
+	MatchingArena(const MatchingArena&) = delete;
+	MatchingArena& operator = (const MatchingArena&) = delete;
+
+	void* allocate(size_t bytes, size_t alignment)
+	{
+		size_t alignedOffset = (m_offset + alignment - 1) & ~(alignment - 1);
+		if (alignedOffset + bytes > m_chunkCapacity)
+		{
+			// Grow geometrically so a single evaluation needs few chunks
+			addChunk(std::max(bytes + alignment, m_chunkCapacity * 2));
+			alignedOffset = 0;
+		}
+		m_offset = alignedOffset + bytes;
+		return m_chunks.back().memory.get() + alignedOffset;
+	}
+
+	Marker getMarker() const
+	{
+		Marker marker = { m_chunks.size(), m_offset };
+		return marker;
+	}
+
+	// Releases everything allocated since the marker was taken, leaving earlier allocations untouched.
+	// Chunks added since then are freed, unless the arena is left empty, which resets it
+	void rewind(const Marker& marker)
+	{
+		if (marker.chunkCount <= 1 && marker.offset == 0)
+		{
+			reset();
+			return;
+		}
+		while (m_chunks.size() > marker.chunkCount)
+		{
+			m_totalCapacity -= m_chunks.back().capacity;
+			m_chunks.pop_back();
+		}
+		m_chunkCapacity = m_chunks.back().capacity;
+		m_offset = marker.offset;
+	}
+
+	// Releases everything allocated from the arena. If the arena had to grow, its chunks are replaced by a single
+	//  chunk of the combined size, up to maxRetainedCapacity, so later evaluations of similar cost never touch the heap
+	void reset()
+	{
+		if (m_chunks.size() > 1 || m_totalCapacity > m_maxRetainedCapacity)
+		{
+			size_t totalCapacity = std::min(m_totalCapacity, m_maxRetainedCapacity);
+			m_chunks.clear();
+			m_totalCapacity = 0;
+			addChunk(totalCapacity);
+		}
+		m_offset = 0;
+	}
+
+	size_t getCapacity() const { return m_totalCapacity; }
+
+	// Arena shared by all evaluations on the calling thread, avoiding contention on the global heap
+	static MatchingArena& getThreadArena()
+	{
+		static thread_local MatchingArena arena;
+		return arena;
+	}
+
+private:
+	struct Chunk
+	{
+		std::unique_ptr<char[]> memory;
+		size_t capacity;
+	};
+
+	void addChunk(size_t capacity)
+	{
+		// Chunks are aligned to max_align_t by operator new, offsets within them are aligned on allocation
+		Chunk chunk = { std::unique_ptr<char[]>(new char[capacity]), capacity };
+		m_chunks.push_back(std::move(chunk));
+		m_chunkCapacity = capacity;
+		m_totalCapacity += capacity;
+		m_offset = 0;
+	}
+
+	std::vector<Chunk> m_chunks;
+	size_t m_offset;
+	size_t m_chunkCapacity;
+	size_t m_totalCapacity;
+	size_t m_maxRetainedCapacity;
+};
+
+// Releases everything allocated from the arena within this scope when leaving it. Scopes may be nested:
+//  each restores the arena to where it was on entry, so an inner scope never frees memory an outer scope still uses
+class MatchingArenaScope
+{
+public:
+	explicit MatchingArenaScope(MatchingArena& arena) :
+		m_arena(arena),
+		m_marker(arena.getMarker())
+	{
+	}
+
+	~MatchingArenaScope()
+	{
+		m_arena.rewind(m_marker);
+	}
+
+	MatchingArenaScope(const MatchingArenaScope&) = delete;
+	MatchingArenaScope& operator = (const MatchingArenaScope&) = delete;
+
+private:
+	MatchingArena& m_arena;
+	MatchingArena::Marker m_marker;
+};
+
+// Allocator drawing from a MatchingArena, or from the global heap when default constructed.
+// Containers built without an arena therefore behave exactly like those using std::allocator
+template <typename T>
+class ArenaAllocator
+{
+public:
+	// Allocators are not propagated on assignment, so arena memory cannot leak into a heap-backed container
+	using value_type = T;
+
+	ArenaAllocator() noexcept :
+		m_arena(nullptr)
+	{
+	}
+
+	explicit ArenaAllocator(MatchingArena* arena) noexcept :
+		m_arena(arena)
+	{
+	}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept :
+		m_arena(other.getArena())
+	{
+	}
+
+	T* allocate(size_t count)
+	{
+		if (m_arena != nullptr)
+		{
+			return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T)));
+		}
+		return static_cast<T*>(::operator new(count * sizeof(T)));
+	}
+
+	void deallocate(T* pointer, size_t) noexcept
+	{
+		// Arena memory is reclaimed in bulk when the arena is reset
+		if (m_arena == nullptr)
+		{
+			::operator delete(pointer);
+		}
+	}
+
+	MatchingArena* getArena() const noexcept { return m_arena; }
+
+private:
+	MatchingArena* m_arena;
+};
+
+template <typename T, typename U>
+inline bool operator == (const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs)
+{
+	return lhs.getArena() == rhs.getArena();
+}
+
+template <typename T, typename U>
+inline bool operator != (const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs)
+{
+	return !(lhs == rhs);
+}
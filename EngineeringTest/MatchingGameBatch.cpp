@@ -0,0 +1,364 @@
+#include "MatchingGameBatch.h"
+
+#include "MatchingGameRanking.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+const int MaxBoardDimension = 1024;
+
+struct BestMoveResult
+{
+	bool foundMove;
+	Move move;
+	int score;
+};
+
+struct BoardBatch
+{
+	size_t sequence;
+	std::vector<Board> boards;
+	std::vector<BestMoveResult> results;
+};
+
+// Skips whitespace and comments, returning the next significant character or EOF
+int readSignificantChar(FILE* input)
+{
+	int c = fgetc(input);
+	while (c != EOF)
+	{
+		if (c == '#')
+		{
+			while (c != EOF && c != '\n')
+			{
+				c = fgetc(input);
+			}
+		}
+		else if (!isspace(c))
+		{
+			break;
+		}
+		else
+		{
+			c = fgetc(input);
+		}
+	}
+	return c;
+}
+
+bool tryReadDimension(FILE* input, int& out_value)
+{
+	int c = readSignificantChar(input);
+	if (c == EOF)
+	{
+		return false;
+	}
+	if (!isdigit(c))
+	{
+		throw std::runtime_error("Expected a board dimension");
+	}
+	out_value = 0;
+	for (; c != EOF && isdigit(c); c = fgetc(input))
+	{
+		out_value = std::min(out_value * 10 + (c - '0'), MaxBoardDimension + 1);
+	}
+	if (c != EOF)
+	{
+		ungetc(c, input);
+	}
+	return true;
+}
+
+bool tryReadUInt16(FILE* input, int& out_value)
+{
+	unsigned char bytes[2];
+	size_t bytesRead = fread(bytes, 1, sizeof(bytes), input);
+	if (bytesRead == 0)
+	{
+		return false;
+	}
+	if (bytesRead != sizeof(bytes))
+	{
+		throw std::runtime_error("Truncated board header");
+	}
+	out_value = bytes[0] | (bytes[1] << 8);
+	return true;
+}
+
+void validateDimensions(int width, int height)
+{
+	if (width <= 0 || height <= 0 || width > MaxBoardDimension || height > MaxBoardDimension)
+	{
+		throw std::runtime_error("Board dimensions must be between 1 and " + std::to_string(MaxBoardDimension));
+	}
+}
+
+JewelKind toJewelKind(int value)
+{
+	if (value < Empty || value > Violet)
+	{
+		throw std::runtime_error("Cell value out of range: " + std::to_string(value));
+	}
+	return (JewelKind)value;
+}
+
+// Ranks the board once, keeping only the best move and the score it was ranked with
+BestMoveResult evaluateBoard(const Board& board)
+{
+	BestMoveResult result = {};
+	TopRankedMoves<1> bestMoves = calculateTopMovesForBoard<1>(board);
+	if (!bestMoves.empty())
+	{
+		const ScoredMove& best = bestMoves.getBest();
+		result.foundMove = true;
+		result.move = best.move;
+		result.score = best.score;
+	}
+	return result;
+}
+
+void writeResult(FILE* output, const BestMoveResult& result)
+{
+	if (result.foundMove)
+	{
+		fprintf(output, "%d %d %s %d\n", result.move.x, result.move.y, moveDirectionToString(result.move.direction).c_str(), result.score);
+	}
+	else
+	{
+		fprintf(output, "none\n");
+	}
+}
+
+} // namespace
+
+bool readBoard(FILE* input, BoardStreamFormat format, Board& out_board)
+{
+	int width;
+	int height;
+	if (format == BoardStreamFormat::Binary)
+	{
+		if (!tryReadUInt16(input, width))
+		{
+			return false;
+		}
+		if (!tryReadUInt16(input, height))
+		{
+			throw std::runtime_error("Truncated board header");
+		}
+		validateDimensions(width, height);
+
+		std::vector<unsigned char> cells(width * height);
+		if (fread(cells.data(), 1, cells.size(), input) != cells.size())
+		{
+			throw std::runtime_error("Truncated board cells");
+		}
+		out_board = Board(width, height);
+		for (int i = 0; i < width * height; i++)
+		{
+			out_board.setJewel(i % width, i / width, toJewelKind(cells[i]));
+		}
+		return true;
+	}
+
+	if (!tryReadDimension(input, width))
+	{
+		return false;
+	}
+	if (!tryReadDimension(input, height))
+	{
+		throw std::runtime_error("Truncated board header");
+	}
+	validateDimensions(width, height);
+
+	out_board = Board(width, height);
+	for (int i = 0; i < width * height; i++)
+	{
+		int c = readSignificantChar(input);
+		if (c == EOF)
+		{
+			throw std::runtime_error("Truncated board cells");
+		}
+		if (!isdigit(c))
+		{
+			throw std::runtime_error(std::string("Unexpected character in board cells: ") + (char)c);
+		}
+		out_board.setJewel(i % width, i / width, toJewelKind(c - '0'));
+	}
+	return true;
+}
+
+MatchingBatchProcessor::MatchingBatchProcessor(const BatchConfig& config) :
+	m_config(config)
+{
+	if (m_config.batchSize <= 0)
+	{
+		throw std::invalid_argument("Batch size must be positive");
+	}
+	if (m_config.threadCount == 0)
+	{
+		m_config.threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+}
+
+BatchStats MatchingBatchProcessor::run(FILE* input, FILE* output)
+{
+	// Bounds memory use: reading stalls once this many batches are waiting to be evaluated or written
+	const size_t maxBatchesInFlight = m_config.threadCount * 2;
+
+	std::mutex mutex;
+	std::condition_variable batchReady;
+	std::condition_variable batchEvaluated;
+	std::condition_variable batchWritten;
+	std::deque<std::unique_ptr<BoardBatch>> pendingBatches;
+	std::map<size_t, std::unique_ptr<BoardBatch>> evaluatedBatches; // Keyed by sequence, so results are written in input order
+	size_t batchesInFlight = 0;
+	size_t batchesRead = 0;
+	bool endOfInput = false;
+	long long boardsWithoutMoves = 0;
+
+	// Each worker evaluates a whole batch at a time
+	auto evaluateWorker = [&]()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;)
+		{
+			batchReady.wait(lock, [&]() { return !pendingBatches.empty() || endOfInput; });
+			if (pendingBatches.empty())
+			{
+				break;
+			}
+			std::unique_ptr<BoardBatch> batch = std::move(pendingBatches.front());
+			pendingBatches.pop_front();
+			lock.unlock();
+
+			batch->results.reserve(batch->boards.size());
+			for (const auto& board : batch->boards)
+			{
+				batch->results.push_back(evaluateBoard(board));
+			}
+
+			lock.lock();
+			size_t sequence = batch->sequence;
+			evaluatedBatches[sequence] = std::move(batch);
+			batchEvaluated.notify_all();
+		}
+	};
+
+	// Writes evaluated batches strictly in sequence, waiting for any batch that is still being evaluated
+	auto writeWorker = [&]()
+	{
+		size_t nextSequence = 0;
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;)
+		{
+			batchEvaluated.wait(lock, [&]() { return evaluatedBatches.count(nextSequence) > 0 || (endOfInput && nextSequence == batchesRead); });
+			auto it = evaluatedBatches.find(nextSequence);
+			if (it == evaluatedBatches.end())
+			{
+				break;
+			}
+			std::unique_ptr<BoardBatch> batch = std::move(it->second);
+			evaluatedBatches.erase(it);
+			lock.unlock();
+
+			long long missingMoves = 0;
+			for (const auto& result : batch->results)
+			{
+				writeResult(output, result);
+				missingMoves += result.foundMove ? 0 : 1;
+			}
+
+			lock.lock();
+			boardsWithoutMoves += missingMoves;
+			batchesInFlight--;
+			nextSequence++;
+			batchWritten.notify_one();
+		}
+		fflush(output);
+	};
+
+	auto start = Clock::now();
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < m_config.threadCount; i++)
+	{
+		workers.emplace_back(evaluateWorker);
+	}
+	std::thread writer(writeWorker);
+
+	// Read on the calling thread, handing each full batch to the workers. On a malformed board, every board before
+	//  it is still evaluated and written before the error is reported
+	long long boardsProcessed = 0;
+	std::string readError;
+	bool moreBoards = true;
+	while (moreBoards)
+	{
+		std::unique_ptr<BoardBatch> batch(new BoardBatch());
+		Board board(0, 0);
+		while ((int)batch->boards.size() < m_config.batchSize && moreBoards)
+		{
+			try
+			{
+				moreBoards = readBoard(input, m_config.inputFormat, board);
+			}
+			catch (const std::runtime_error& error)
+			{
+				readError = error.what();
+				moreBoards = false;
+			}
+			if (moreBoards)
+			{
+				batch->boards.push_back(board);
+			}
+		}
+		if (batch->boards.empty())
+		{
+			break;
+		}
+		boardsProcessed += batch->boards.size();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		batchWritten.wait(lock, [&]() { return batchesInFlight < maxBatchesInFlight; });
+		batch->sequence = batchesRead++;
+		batchesInFlight++;
+		pendingBatches.push_back(std::move(batch));
+		batchReady.notify_one();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		endOfInput = true;
+	}
+	batchReady.notify_all();
+	batchEvaluated.notify_all();
+	for (auto& thread : workers)
+	{
+		thread.join();
+	}
+	writer.join();
+
+	if (!readError.empty())
+	{
+		throw std::runtime_error("Board " + std::to_string(boardsProcessed) + ": " + readError);
+	}
+
+	BatchStats stats = {};
+	stats.boardsProcessed = boardsProcessed;
+	stats.boardsWithoutMoves = boardsWithoutMoves;
+	stats.elapsedS = std::chrono::duration<double>(Clock::now() - start).count();
+	stats.boardsPerSecond = (stats.elapsedS > 0) ? boardsProcessed / stats.elapsedS : 0.0;
+	return stats;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "MatchingGameDecl.h"
+
+#include <cstdio>
+
+enum class BoardStreamFormat
+{
+	// Each board is "width height" followed by width*height cell digits (0 for Empty, 1 to 7 for Red to Violet),
+	//  row by row from y = 0. Whitespace between cells is ignored and '#' starts a comment running to the end of the line
+	Text,
+	// Each board is a little-endian uint16 width and height, followed by width*height bytes of JewelKind values
+	Binary
+};
+
+struct BatchConfig
+{
+	BoardStreamFormat inputFormat = BoardStreamFormat::Text;
+	int batchSize = 256; // Boards read, evaluated and written together
+	unsigned int threadCount = 0; // Zero uses every available hardware thread
+};
+
+struct BatchStats
+{
+	long long boardsProcessed;
+	long long boardsWithoutMoves;
+	double elapsedS;
+	double boardsPerSecond;
+};
+
+// Reads the next board from the stream, returning false once the stream ends cleanly between boards.
+// Throws std::runtime_error if a board is truncated or malformed, or wider or higher than 1024 cells
+bool readBoard(FILE* input, BoardStreamFormat format, Board& out_board);
+
+// Streams boards from 'input' and writes the best move for each to 'output' as one line per board, in input order:
+//  "x y Direction score", or "none" when the board has no scoring move. As with calculateBestMoveForBoard, moves
+//  with equal scores are ordered by row, then column, then Up before Right, and the first is written.
+// Reading, evaluation across worker threads and writing are pipelined, so later batches are read and evaluated
+//  while earlier ones are still being written
+class MatchingBatchProcessor
+{
+public:
+	explicit MatchingBatchProcessor(const BatchConfig& config);
+
+	// Blocks until the input is exhausted and every result has been written
+	BatchStats run(FILE* input, FILE* output);
+
+private:
+	BatchConfig m_config;
+};
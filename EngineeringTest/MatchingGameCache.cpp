@@ -0,0 +1,84 @@
+#include "MatchingGameCache.h"
+
+RankedMovesCache::RankedMovesCache(size_t capacity, size_t shardCount) :
+	m_hits(0),
+	m_misses(0),
+	m_evictions(0)
+{
+	shardCount = (shardCount > 0) ? shardCount : 1;
+	// Round up so the cache never holds fewer entries than requested
+	m_capacityPerShard = (capacity + shardCount - 1) / shardCount;
+	m_capacityPerShard = (m_capacityPerShard > 0) ? m_capacityPerShard : 1;
+	for (size_t i = 0; i < shardCount; i++)
+	{
+		m_shards.push_back(std::unique_ptr<Shard>(new Shard()));
+	}
+}
+
+std::shared_ptr<const RankedMoves> RankedMovesCache::find(const Board& board)
+{
+	uint64_t hash = board.calculateHash();
+	Shard& shard = getShardForHash(hash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto existing = shard.lookup.find(hash);
+	if (existing != shard.lookup.end() && existing->second->board == board)
+	{
+		// Promote to most recently used without reallocating the entry
+		shard.entries.splice(shard.entries.begin(), shard.entries, existing->second);
+		m_hits.fetch_add(1, std::memory_order_relaxed);
+		return existing->second->moves;
+	}
+
+	m_misses.fetch_add(1, std::memory_order_relaxed);
+	return nullptr;
+}
+
+void RankedMovesCache::insert(const Board& board, std::shared_ptr<const RankedMoves> moves)
+{
+	uint64_t hash = board.calculateHash();
+	Shard& shard = getShardForHash(hash);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto existing = shard.lookup.find(hash);
+	if (existing != shard.lookup.end())
+	{
+		// Either the same board evaluated concurrently, or a hash collision; the newest result replaces it
+		shard.entries.erase(existing->second);
+		shard.lookup.erase(existing);
+	}
+	else if (shard.entries.size() >= m_capacityPerShard)
+	{
+		shard.lookup.erase(shard.entries.back().hash);
+		shard.entries.pop_back();
+		m_evictions.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	shard.entries.emplace_front(hash, board, std::move(moves));
+	shard.lookup[hash] = shard.entries.begin();
+}
+
+void RankedMovesCache::clear()
+{
+	for (auto& shard : m_shards)
+	{
+		std::lock_guard<std::mutex> lock(shard->mutex);
+		shard->entries.clear();
+		shard->lookup.clear();
+	}
+}
+
+RankedMovesCacheStats RankedMovesCache::getStats() const
+{
+	RankedMovesCacheStats stats;
+	stats.hits = m_hits.load(std::memory_order_relaxed);
+	stats.misses = m_misses.load(std::memory_order_relaxed);
+	stats.evictions = m_evictions.load(std::memory_order_relaxed);
+	stats.entries = 0;
+	for (const auto& shard : m_shards)
+	{
+		std::lock_guard<std::mutex> lock(shard->mutex);
+		stats.entries += shard->entries.size();
+	}
+	return stats;
+}
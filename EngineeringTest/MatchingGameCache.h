@@ -0,0 +1,65 @@
+#pragma once
+
+#include "MatchingGameDecl.h"
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+struct RankedMovesCacheStats
+{
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	size_t entries;
+};
+
+// Thread-safe, bounded LRU cache of evaluated boards, keyed by Board::calculateHash()
+// Entries are spread across independently locked shards to reduce contention between threads
+class RankedMovesCache
+{
+public:
+	RankedMovesCache(size_t capacity, size_t shardCount = 16);
+
+	// Returns nullptr on a miss. Boards are compared in full on a hash match, so collisions are never returned
+	std::shared_ptr<const RankedMoves> find(const Board& board);
+	void insert(const Board& board, std::shared_ptr<const RankedMoves> moves);
+	void clear();
+
+	RankedMovesCacheStats getStats() const;
+
+private:
+	struct Entry
+	{
+		Entry(uint64_t newHash, const Board& newBoard, std::shared_ptr<const RankedMoves> newMoves) :
+			hash(newHash),
+			board(newBoard),
+			moves(std::move(newMoves))
+		{
+		}
+
+		uint64_t hash;
+		Board board;
+		std::shared_ptr<const RankedMoves> moves;
+	};
+
+	// Most recently used entries are kept at the front of the list
+	using EntryList = std::list<Entry>;
+
+	struct Shard
+	{
+		std::mutex mutex;
+		EntryList entries;
+		std::unordered_map<uint64_t, EntryList::iterator> lookup;
+	};
+
+	Shard& getShardForHash(uint64_t hash) { return *m_shards[(hash >> 32) % m_shards.size()]; }
+
+	std::vector<std::unique_ptr<Shard>> m_shards;
+	size_t m_capacityPerShard;
+	std::atomic<uint64_t> m_hits;
+	std::atomic<uint64_t> m_misses;
+	std::atomic<uint64_t> m_evictions;
+};
@@ -1,6 +1,11 @@
 #pragma once
 
+#include "MatchingGameArena.h"
+
+#include <algorithm>
+#include <cstdint>
 #include <map>
+#include <scoped_allocator>
 #include <set>
 #include <vector>
 
@@ -51,31 +56,99 @@ inline bool operator < (const BoardCell& lhs, const BoardCell& rhs)
 	return (lhs.x < rhs.x || (lhs.x == rhs.x && lhs.y < rhs.y));
 }
 
-using BoardCellCollection = std::set<BoardCell>;
-using MatchedCellsCollection = std::vector<BoardCellCollection>;
+// Matching containers are short-lived during move evaluation, and can be backed by a MatchingArena.
+// Default constructed allocators use the global heap
+using MatchingAllocator = ArenaAllocator<BoardCell>;
+using BoardCellCollection = std::set<BoardCell, std::less<BoardCell>, MatchingAllocator>;
+// Scoped so that each nested BoardCellCollection allocates from the same arena as the outer vector
+using MatchedCellsCollection = std::vector<BoardCellCollection, std::scoped_allocator_adaptor<ArenaAllocator<BoardCellCollection>>>;
+// Cells in a flat list, such as the matched cells gathered by repopulateBoardAfterMatches
+using BoardCellList = std::vector<BoardCell, MatchingAllocator>;
 using RankedMoves = std::map<int, std::vector<Move>>;
 
+// Mixes a 64-bit value into a well-distributed hash (SplitMix64 finalizer)
+inline uint64_t mixHash(uint64_t value)
+{
+	value += 0x9E3779B97F4A7C15ull;
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
 // Implementation added to allow functional demonstration
+// Cells are stored in square tiles of TileSize x TileSize, each contiguous in memory, so that vertical neighbours
+//  are usually in the same cache lines as the cell itself. Tiles along the right and top edges are padded with Empty cells
 class Board
 {
 public:
+	static const int TileShift = 3;
+	static const int TileSize = 1 << TileShift;
+
 	Board(int width, int height) :
 		m_width(width),
-		m_height(height)
+		m_height(height),
+		m_tileCountX((width + TileSize - 1) >> TileShift),
+		m_tileCountY((height + TileSize - 1) >> TileShift)
 	{
-		m_cells.resize(width * height);
+		m_cells.resize((size_t)m_tileCountX * m_tileCountY * TileSize * TileSize);
+		m_dirtyTiles.resize((size_t)m_tileCountX * m_tileCountY);
 	}
 
 	int getWidth() const { return m_width; }
 	int getHeight() const { return m_height; }
 
-	JewelKind getJewel(int x, int y) const { return m_cells[y*m_width + x]; }
-	void setJewel(int x, int y, JewelKind kind) { m_cells[y*m_width + x] = kind; }
+	JewelKind getJewel(int x, int y) const { return m_cells[getCellIndex(x, y)]; }
+	void setJewel(int x, int y, JewelKind kind)
+	{
+		m_cells[getCellIndex(x, y)] = kind;
+		m_dirtyTiles[(y >> TileShift) * m_tileCountX + (x >> TileShift)] = 1;
+	}
+
+	int getTileCountX() const { return m_tileCountX; }
+	int getTileCountY() const { return m_tileCountY; }
+
+	// A tile is marked dirty whenever setJewel is called for one of its cells, until the flags are cleared
+	bool isTileDirty(int tileX, int tileY) const { return m_dirtyTiles[tileY * m_tileCountX + tileX] != 0; }
+	void clearDirtyTiles() { std::fill(m_dirtyTiles.begin(), m_dirtyTiles.end(), (uint8_t)0); }
+
+	// 64-bit hash of the board dimensions and contents. This visits every cell, so it is only calculated on demand,
+	//  such as when looking a board up in a RankedMovesCache, rather than kept up to date by every setJewel.
+	// Cells are keyed by row-major position, so the hash does not depend on the tile layout
+	uint64_t calculateHash() const
+	{
+		uint64_t hash = mixHash(((uint64_t)m_width << 32) | (uint32_t)m_height);
+		for (int y = 0; y < m_height; y++)
+		{
+			for (int x = 0; x < m_width; x++)
+			{
+				JewelKind kind = getJewel(x, y);
+				if (kind != Empty)
+				{
+					hash ^= mixHash(((uint64_t)(y*m_width + x) << 3) | (uint64_t)kind);
+				}
+			}
+		}
+		return hash;
+	}
+
+	bool operator == (const Board& other) const
+	{
+		return m_width == other.m_width && m_height == other.m_height && m_cells == other.m_cells;
+	}
 
 private:
+	size_t getCellIndex(int x, int y) const
+	{
+		size_t tileIndex = (size_t)(y >> TileShift) * m_tileCountX + (x >> TileShift);
+		return (tileIndex << (TileShift * 2)) | ((y & (TileSize - 1)) << TileShift) | (x & (TileSize - 1));
+	}
+
 	std::vector<JewelKind> m_cells;
+	std::vector<uint8_t> m_dirtyTiles;
 	int m_width;
 	int m_height;
+	int m_tileCountX;
+	int m_tileCountY;
 };
 
 inline std::string moveDirectionToString(MoveDirection direction)
@@ -122,6 +195,45 @@ inline bool getIndexAfterMove(const Move& move, int& out_x, int& out_y)
 	return true;
 }
 
+// Visits every swap that can be made on the board, in the order moves are ranked.
+// Only 'Up' and 'Right' are considered, as they cover the same swaps as 'Down' and 'Left'.
+// The visitor returns false to stop the traversal early
+template <typename MoveVisitor>
+inline void forEachCandidateMoveForBoard(const Board& board, MoveVisitor&& visitor)
+{
+	int boardWidth = board.getWidth();
+	int boardHeight = board.getHeight();
+	Move workingMove;
+
+	// Traverse the board sequentially
+	for (int y = 0; y < boardHeight; y++)
+	{
+		for (int x = 0; x < boardWidth; x++)
+		{
+			workingMove.x = x;
+			workingMove.y = y;
+
+			// This function assumes 'Up' and 'Right' are positive changes in index
+			if (y < boardHeight - 1)
+			{
+				workingMove.direction = MoveDirection::Up;
+				if (!visitor(workingMove))
+				{
+					return;
+				}
+			}
+			if (x < boardWidth - 1)
+			{
+				workingMove.direction = MoveDirection::Right;
+				if (!visitor(workingMove))
+				{
+					return;
+				}
+			}
+		}
+	}
+}
+
 inline bool performMoveForBoard(const Move& move, Board& out_board)
 {
 	int targetX, targetY;
@@ -144,7 +256,7 @@ inline bool performMoveForBoard(const Move& move, Board& out_board)
 
 inline BoardCellCollection findNewAdjacentCells(const BoardCell& currentCell, const Board& board, const BoardCellCollection& visitedCells)
 {
-	BoardCellCollection adjacentCells;
+	BoardCellCollection adjacentCells(visitedCells.get_allocator());
 	if (currentCell.x > 0)
 	{
 		adjacentCells.insert(BoardCell(currentCell.x - 1, currentCell.y));
@@ -166,10 +278,20 @@ inline BoardCellCollection findNewAdjacentCells(const BoardCell& currentCell, co
 
 inline void addMatchingCellsToCollection(const BoardCell& currentCell, const Board& board, BoardCellCollection& out_matchedCells, BoardCellCollection& out_visitedCells)
 {
-	BoardCellCollection cellsToTest = findNewAdjacentCells(currentCell, board, out_visitedCells);
 	JewelKind kindToMatch = board.getJewel(currentCell.x, currentCell.y);
-	if (kindToMatch != Empty)
+	if (kindToMatch == Empty)
 	{
+		return;
+	}
+
+	// Cells still to be searched are kept on an explicit stack rather than by recursing, so a single large group
+	//  cannot overflow the call stack
+	BoardCellList cellsToSearch(1, currentCell, out_visitedCells.get_allocator());
+	while (!cellsToSearch.empty())
+	{
+		BoardCell searchCell = cellsToSearch.back();
+		cellsToSearch.pop_back();
+		BoardCellCollection cellsToTest = findNewAdjacentCells(searchCell, board, out_visitedCells);
 		for (const auto& adjacentCell : cellsToTest)
 		{
 			if (out_visitedCells.count(adjacentCell) == 0)
@@ -177,9 +299,9 @@ inline void addMatchingCellsToCollection(const BoardCell& currentCell, const Boa
 				out_visitedCells.insert(adjacentCell);
 				if (board.getJewel(adjacentCell.x, adjacentCell.y) == kindToMatch)
 				{
-					// Found a match, recurse to search for additional matches
+					// Found a match, search it for additional matches
 					out_matchedCells.insert(adjacentCell);
-					addMatchingCellsToCollection(adjacentCell, board, out_matchedCells, out_visitedCells);
+					cellsToSearch.push_back(adjacentCell);
 				}
 			}
 		}
@@ -189,26 +311,44 @@ inline void addMatchingCellsToCollection(const BoardCell& currentCell, const Boa
 inline void repopulateBoardAfterMatches(const MatchedCellsCollection& matchedGroups, Board& out_board)
 {
 	// Optional check: once jewels have been matched, the board may repopulate and cascade for more points
-	// Remap collection into BoardCellCollection, sorted by row and column in ascending order
-	BoardCellCollection matchedCells;
+	// Gather matched cells sorted by column and row in ascending order, counting cells shared by several groups once
+	MatchingAllocator allocator(matchedGroups.get_allocator());
+	BoardCellList matchedCells(allocator);
 	for (const auto& collection : matchedGroups)
 	{
-		for (const auto& cell : collection)
-		{
-			matchedCells.insert(cell);
-		}
+		matchedCells.insert(matchedCells.end(), collection.begin(), collection.end());
 	}
-
-	// Traverse the board where matches were made, moving jewels down into empty spaces
-	// Begin from the top of the board to avoid shifting matched cells still to be resolved
-	for (auto it = matchedCells.crbegin(); it != matchedCells.crend(); ++it)
+	std::sort(matchedCells.begin(), matchedCells.end());
+	matchedCells.erase(std::unique(matchedCells.begin(), matchedCells.end(),
+		[](const BoardCell& lhs, const BoardCell& rhs) { return lhs.x == rhs.x && lhs.y == rhs.y; }), matchedCells.end());
+
+	// Compact each affected column in a single pass, starting from its lowest matched cell. Remaining jewels move
+	//  down over the matched cells in their original order, and the space left at the top of the column is emptied.
+	// Board::setJewel marks the tiles of every changed cell dirty, which is all the cascade scan needs
+	auto match = matchedCells.cbegin();
+	while (match != matchedCells.cend())
 	{
-		const auto& cell = *it;
-		for (int y = cell.y; y < out_board.getHeight() - 1; y++)
+		int x = match->x;
+		int writeY = match->y;
+		for (int readY = writeY; readY < out_board.getHeight(); readY++)
+		{
+			if (match != matchedCells.cend() && match->x == x && match->y == readY)
+			{
+				++match;
+			}
+			else
+			{
+				if (writeY != readY)
+				{
+					out_board.setJewel(x, writeY, out_board.getJewel(x, readY));
+				}
+				writeY++;
+			}
+		}
+		for (; writeY < out_board.getHeight(); writeY++)
 		{
-			out_board.setJewel(cell.x, y, out_board.getJewel(cell.x, y + 1));
+			out_board.setJewel(x, writeY, JewelKind::Empty);
 		}
-		out_board.setJewel(cell.x, out_board.getHeight() - 1, JewelKind::Empty);
 	}
 }
 
@@ -223,85 +363,269 @@ inline void resolveMatchesForBoard(const MatchedCellsCollection& potentialMatche
 	}
 }
 
-inline MatchedCellsCollection resolveCascadingMatches(Board& out_board)
+// Records the cells already assigned to a group during a single board scan, in a flat array indexed by cell rather than a set.
+// The array is kept per thread and each scan stamps it with a new generation, so it never needs clearing between scans.
+// A scan started on a thread while another is still in progress uses an array of its own
+class BoardScanMarks
 {
-	// Depending on the behaviour of repopulating the board, we could intelligently check areas which may have new matches.
-	// This code simply scans the entire board
-	BoardCellCollection cellsToCheck;
-	for (int y = 0; y < out_board.getHeight(); y++)
+public:
+	explicit BoardScanMarks(const Board& board) :
+		m_width(board.getWidth()),
+		m_state(getThreadState().isInUse ? m_ownState : getThreadState())
 	{
-		for (int x = 0; x < out_board.getWidth(); x++)
+		m_state.isInUse = true;
+		size_t cellCount = (size_t)board.getWidth() * board.getHeight();
+		if (m_state.stamps.size() < cellCount)
 		{
-			cellsToCheck.insert(BoardCell(x, y));
+			m_state.stamps.resize(cellCount, 0);
+		}
+		if (++m_state.generation == 0)
+		{
+			// Stamps from 2^32 scans ago would otherwise appear marked again
+			std::fill(m_state.stamps.begin(), m_state.stamps.end(), 0u);
+			m_state.generation = 1;
 		}
 	}
-	MatchedCellsCollection cascadeMatches;
-	for (const auto& cell : cellsToCheck)
+
+	~BoardScanMarks() { m_state.isInUse = false; }
+
+	BoardScanMarks(const BoardScanMarks&) = delete;
+	BoardScanMarks& operator = (const BoardScanMarks&) = delete;
+
+	bool isMarked(int x, int y) const { return m_state.stamps[(size_t)y * m_width + x] == m_state.generation; }
+	void mark(int x, int y) { m_state.stamps[(size_t)y * m_width + x] = m_state.generation; }
+
+	// Scratch list for the group being gathered, reused so that each flood fill does not allocate
+	std::vector<BoardCell>& getGroupCells() { return m_state.groupCells; }
+
+private:
+	struct ScanState
 	{
-		BoardCellCollection matchedCells;
-		addMatchingCellsToCollection(cell, out_board, matchedCells, BoardCellCollection());
-		if (matchedCells.size() >= NumberOfColorsToMatch)
+		std::vector<uint32_t> stamps;
+		std::vector<BoardCell> groupCells;
+		uint32_t generation = 0;
+		bool isInUse = false;
+	};
+
+	static ScanState& getThreadState()
+	{
+		static thread_local ScanState state;
+		return state;
+	}
+
+	int m_width;
+	ScanState m_ownState; // Unused unless the thread's state was already in use; declared before m_state to be constructed first
+	ScanState& m_state;
+};
+
+// Finds every group of matching cells with at least one cell inside the given tile, scanning the tile's cells
+//  contiguously. Groups may extend into neighbouring tiles. Every cell of a group is marked as soon as the group is
+//  gathered, whether or not it is long enough to match, so each group is flood filled and reported once per scan
+inline void findMatchesInTile(int tileX, int tileY, const Board& board, BoardScanMarks& groupedCells, MatchedCellsCollection& out_matches)
+{
+	MatchingAllocator allocator(out_matches.get_allocator());
+	std::vector<BoardCell>& groupCells = groupedCells.getGroupCells();
+	int beginX = tileX << Board::TileShift;
+	int beginY = tileY << Board::TileShift;
+	int endX = std::min(beginX + Board::TileSize, board.getWidth());
+	int endY = std::min(beginY + Board::TileSize, board.getHeight());
+	for (int y = beginY; y < endY; y++)
+	{
+		for (int x = beginX; x < endX; x++)
 		{
-			cascadeMatches.push_back(matchedCells);
+			JewelKind kindToMatch = board.getJewel(x, y);
+			if (kindToMatch == Empty || groupedCells.isMarked(x, y))
+			{
+				continue;
+			}
+
+			// Breadth-first flood fill, using the gathered cells themselves as the queue
+			groupCells.clear();
+			groupCells.push_back(BoardCell(x, y));
+			groupedCells.mark(x, y);
+			for (size_t i = 0; i < groupCells.size(); i++)
+			{
+				BoardCell cell = groupCells[i];
+				auto visitAdjacentCell = [&](int adjacentX, int adjacentY)
+				{
+					if (!groupedCells.isMarked(adjacentX, adjacentY) && board.getJewel(adjacentX, adjacentY) == kindToMatch)
+					{
+						groupedCells.mark(adjacentX, adjacentY);
+						groupCells.push_back(BoardCell(adjacentX, adjacentY));
+					}
+				};
+				if (cell.x > 0)
+				{
+					visitAdjacentCell(cell.x - 1, cell.y);
+				}
+				if (cell.y > 0)
+				{
+					visitAdjacentCell(cell.x, cell.y - 1);
+				}
+				if (cell.x < board.getWidth() - 1)
+				{
+					visitAdjacentCell(cell.x + 1, cell.y);
+				}
+				if (cell.y < board.getHeight() - 1)
+				{
+					visitAdjacentCell(cell.x, cell.y + 1);
+				}
+			}
+
+			if (groupCells.size() >= NumberOfColorsToMatch)
+			{
+				out_matches.push_back(BoardCellCollection(groupCells.begin(), groupCells.end(), std::less<BoardCell>(), allocator));
+			}
 		}
 	}
+}
 
+inline MatchedCellsCollection resolveCascadingMatches(Board& out_board, const MatchingAllocator& allocator = MatchingAllocator())
+{
+	// This code simply scans the entire board, tile by tile
+	BoardScanMarks groupedCells(out_board);
+	MatchedCellsCollection cascadeMatches(allocator);
+	for (int tileY = 0; tileY < out_board.getTileCountY(); tileY++)
+	{
+		for (int tileX = 0; tileX < out_board.getTileCountX(); tileX++)
+		{
+			findMatchesInTile(tileX, tileY, out_board, groupedCells, cascadeMatches);
+		}
+	}
 	return cascadeMatches;
 }
 
-inline MatchedCellsCollection findMatchesAfterMoveForBoard(const Move& move, const Board& board)
+// As resolveCascadingMatches, scanning only the tiles changed since their dirty flags were last cleared, then
+//  clearing them. Any new match must include a changed cell, so this finds every match provided the board had
+//  none when the flags were cleared
+inline MatchedCellsCollection resolveCascadingMatchesInDirtyTiles(Board& out_board, const MatchingAllocator& allocator = MatchingAllocator())
+{
+	BoardScanMarks groupedCells(out_board);
+	MatchedCellsCollection cascadeMatches(allocator);
+	for (int tileY = 0; tileY < out_board.getTileCountY(); tileY++)
+	{
+		for (int tileX = 0; tileX < out_board.getTileCountX(); tileX++)
+		{
+			if (out_board.isTileDirty(tileX, tileY))
+			{
+				findMatchesInTile(tileX, tileY, out_board, groupedCells, cascadeMatches);
+			}
+		}
+	}
+	out_board.clearDirtyTiles();
+	return cascadeMatches;
+}
+
+// True if the board already holds a match before any move is made. Boards from beginGame never do, but boards
+//  read from elsewhere may
+inline bool hasMatchesOnBoard(const Board& board)
+{
+	MatchingArena& arena = MatchingArena::getThreadArena();
+	MatchingArenaScope arenaScope(arena);
+	MatchingAllocator allocator(&arena);
+	BoardScanMarks groupedCells(board);
+	MatchedCellsCollection matches(allocator);
+	for (int tileY = 0; tileY < board.getTileCountY() && matches.empty(); tileY++)
+	{
+		for (int tileX = 0; tileX < board.getTileCountX() && matches.empty(); tileX++)
+		{
+			findMatchesInTile(tileX, tileY, board, groupedCells, matches);
+		}
+	}
+	return !matches.empty();
+}
+
+inline MatchedCellsCollection findMatchesAfterMoveForBoard(const Move& move, const Board& board, const MatchingAllocator& allocator = MatchingAllocator())
 {
 	// Run visit function for source and destination cells to check for matches
 	BoardCell currentCell(move.x, move.y);
-	BoardCellCollection matchedCellsSrc;
-	addMatchingCellsToCollection(currentCell, board, matchedCellsSrc, BoardCellCollection());
+	BoardCellCollection matchedCellsSrc(allocator);
+	BoardCellCollection visitedCellsSrc(allocator);
+	addMatchingCellsToCollection(currentCell, board, matchedCellsSrc, visitedCellsSrc);
 
 	// This code assumes there were no matches before the move. In situations where this is not the case,
 	//  it may incorrectly double the user's score by matching the same cells twice
 	getIndexAfterMove(move, currentCell.x, currentCell.y);
-	BoardCellCollection matchedCellsDst;
-	addMatchingCellsToCollection(currentCell, board, matchedCellsDst, BoardCellCollection());
+	BoardCellCollection matchedCellsDst(allocator);
+	BoardCellCollection visitedCellsDst(allocator);
+	addMatchingCellsToCollection(currentCell, board, matchedCellsDst, visitedCellsDst);
 
-	MatchedCellsCollection potentialMatches = { matchedCellsSrc, matchedCellsDst };
-	MatchedCellsCollection results;
-	for (const auto& matchedCells : potentialMatches)
+	MatchedCellsCollection results(allocator);
+	for (auto* matchedCells : { &matchedCellsSrc, &matchedCellsDst })
 	{
-		if (matchedCells.size() >= NumberOfColorsToMatch)
+		if (matchedCells->size() >= NumberOfColorsToMatch)
 		{
-			results.push_back(matchedCells);
+			results.push_back(std::move(*matchedCells));
 		}
 	}
 	return results;
 }
 
-inline int calculateScoreAfterMoveForBoard(const Move& move, const Board& board)
+inline int countUniqueMatchedCells(const MatchedCellsCollection& matches, const MatchingAllocator& allocator)
+{
+	// Extract into BoardCellCollection to only count each matching cell once
+	BoardCellCollection uniqueCells(allocator);
+	for (const auto& match : matches)
+	{
+		uniqueCells.insert(match.begin(), match.end());
+	}
+	return (int)uniqueCells.size();
+}
+
+// Scoring policies decide how many points each step of a move is worth, and are passed as a template parameter so that
+//  each rule set compiles into its own evaluation loop. A policy provides:
+//  - scoreMatches(matches, cascadeDepth, board, allocator): points for one step, where cascadeDepth is zero for the
+//    move's own match. The board still holds the matched jewels when this is called
+//  - calculateScoreUpperBound(jewelCount): the most a single move can score on a board holding jewelCount jewels,
+//    used to prune moves that cannot beat those already ranked
+// Default rule: one point for every unique matched cell, in the move's own match and in every cascade step
+struct UniqueCellScoringPolicy
 {
+	static int scoreMatches(const MatchedCellsCollection& matches, int, const Board&, const MatchingAllocator& allocator)
+	{
+		return countUniqueMatchedCells(matches, allocator);
+	}
+
+	// No move can clear more jewels than are on the board, as jewels are never refilled
+	static int calculateScoreUpperBound(int jewelCount) { return jewelCount; }
+};
+
+// hasMatchesBeforeMove may be passed as false when the board is known to hold no matches, such as after checking it
+//  once with hasMatchesOnBoard before ranking all of its moves. Otherwise the first cascade scans the whole board
+template <typename ScoringPolicy = UniqueCellScoringPolicy>
+inline int calculateScoreAfterMoveForBoard(const Move& move, const Board& board, bool hasMatchesBeforeMove = true)
+{
+	// Every container used during the evaluation is drawn from this thread's arena, which is reset on return.
+	// The working board is also reused between calls, as copying into it does not reallocate once sized
+	MatchingArena& arena = MatchingArena::getThreadArena();
+	MatchingArenaScope arenaScope(arena);
+	MatchingAllocator allocator(&arena);
+	static thread_local Board workingBoard(0, 0);
+	workingBoard = board;
+	workingBoard.clearDirtyTiles();
+
 	int totalScore = 0;
-	Board workingBoard = board;
 	if (performMoveForBoard(move, workingBoard))
 	{
-		MatchedCellsCollection results = findMatchesAfterMoveForBoard(move, workingBoard);
-		resolveMatchesForBoard(results, workingBoard);
-		repopulateBoardAfterMatches(results, workingBoard);
-
-		// Add up total cell count for matching entries in each collection
-		// Additional rules such as multipliers could be added here
-		auto& cursor = results;
-		while (!cursor.empty())
+		// Score each step before its matches are removed, so that policies can inspect the matched jewels.
+		// Repopulating the board removes every matched cell, whether or not it has been emptied
+		MatchedCellsCollection cursor = findMatchesAfterMoveForBoard(move, workingBoard, allocator);
+		for (int cascadeDepth = 0; !cursor.empty(); cascadeDepth++)
 		{
-			BoardCellCollection uniqueCells;
-			// Extract into BoardCellCollection to only count each matching cell once
-			for (const auto& match : cursor)
+			totalScore += ScoringPolicy::scoreMatches(cursor, cascadeDepth, workingBoard, allocator);
+			repopulateBoardAfterMatches(cursor, workingBoard);
+
+			// Matches already on the board are found by scanning all of it once, as the original scan did. After that,
+			//  or when the board had none, any new match includes a changed cell, so only dirty tiles need scanning
+			if (hasMatchesBeforeMove && cascadeDepth == 0)
 			{
-				for (const auto& cell : match)
-				{
-					uniqueCells.insert(cell);
-				}
+				cursor = resolveCascadingMatches(workingBoard, allocator);
+				workingBoard.clearDirtyTiles();
+			}
+			else
+			{
+				cursor = resolveCascadingMatchesInDirtyTiles(workingBoard, allocator);
 			}
-			totalScore += (int)uniqueCells.size();
-
-			cursor = resolveCascadingMatches(workingBoard);
-			repopulateBoardAfterMatches(cursor, workingBoard);
 		}
 	}
 	else
@@ -311,9 +635,10 @@ inline int calculateScoreAfterMoveForBoard(const Move& move, const Board& board)
 	return totalScore;
 }
 
-inline void rankMoveForBoard(const Move& move, const Board& board, RankedMoves& out_ranking)
+template <typename ScoringPolicy = UniqueCellScoringPolicy>
+inline void rankMoveForBoard(const Move& move, const Board& board, RankedMoves& out_ranking, bool hasMatchesBeforeMove = true)
 {
-	int score = calculateScoreAfterMoveForBoard(move, board);
+	int score = calculateScoreAfterMoveForBoard<ScoringPolicy>(move, board, hasMatchesBeforeMove);
 	if (score > 0)
 	{
 		// Found a valid scoring move, add it to the potential moves
@@ -1,13 +1,28 @@
 #include "MatchingGameExercise.h"
 
+#include "MatchingGameCache.h"
+#include "MatchingGameRanking.h"
+
 #include <random>
 #include <stdexcept>
 
-Board MatchingGameExercise::beginGame(int width, int height)
+Board MatchingGameExercise::beginGame(int width, int height, int colorCount)
+{
+	return beginGame(width, height, colorCount, []() { return rand(); });
+}
+
+Board MatchingGameExercise::beginGame(int width, int height, int colorCount, const std::function<int()>& nextRandom)
 {
+	// Cells are filled in row order, so only the left and lower neighbours are populated when a cell is chosen.
+	// Three colors is therefore the minimum that can always avoid a starting match
+	if (colorCount < 3 || colorCount > Violet)
+	{
+		throw std::invalid_argument("Color count must be between 3 and 7");
+	}
+
 	Board gameBoard(width, height);
 	// Generate a randomized grid with no starting matches
-	// This function assumes there are more Jewel types than Cartesian adjacencies,
+	// This function assumes there are more Jewel types than populated Cartesian adjacencies,
 	//  and can therefore assign values without running out of valid choices
 	for (int y = 0; y < height; y++)
 	{
@@ -17,7 +32,7 @@ Board MatchingGameExercise::beginGame(int width, int height)
 			do
 			{
 				matchedCells.clear();
-				gameBoard.setJewel(x, y, (JewelKind)(rand() % Violet + 1));
+				gameBoard.setJewel(x, y, (JewelKind)(nextRandom() % colorCount + 1));
 				addMatchingCellsToCollection(BoardCell(x, y), gameBoard, matchedCells, BoardCellCollection());
 			}
 			while (matchedCells.size() >= NumberOfColorsToMatch);
@@ -29,54 +44,67 @@ Board MatchingGameExercise::beginGame(int width, int height)
 
 RankedMoves MatchingGameExercise::calculateMovesForBoard(const Board& board)
 {
-	int boardWidth = board.getWidth();
-	int boardHeight = board.getHeight();
-	Board workingBoard = board; // Make a working copy for calculating potential moves
-	Move workingMove;
-
-	// Valid moves ordered by calculated score in ascending order
-	RankedMoves potentialMoves;
+	if (!m_cache)
+	{
+		return calculateMovesForBoardUncached(board);
+	}
+	return *findOrCalculateMovesForBoard(board);
+}
 
-	// Traverse the board sequentially
-	for (int y = 0; y < boardHeight; y++)
+std::shared_ptr<const RankedMoves> MatchingGameExercise::findOrCalculateMovesForBoard(const Board& board)
+{
+	if (m_cache)
 	{
-		for (int x = 0; x < boardWidth; x++)
+		auto cachedMoves = m_cache->find(board);
+		if (cachedMoves)
 		{
-			workingMove.x = x;
-			workingMove.y = y;
-
-			// This function assumes 'Up' and 'Right' are positive changes in index
-			if (y < boardHeight - 1)
-			{
-				workingMove.direction = MoveDirection::Up;
-				rankMoveForBoard(workingMove, workingBoard, potentialMoves);
-			}
-			if (x < boardWidth - 1)
-			{
-				workingMove.direction = MoveDirection::Right;
-				rankMoveForBoard(workingMove, workingBoard, potentialMoves);
-			}
+			return cachedMoves;
 		}
 	}
 
-	return potentialMoves;
+	auto moves = std::make_shared<const RankedMoves>(calculateMovesForBoardUncached(board));
+	if (m_cache)
+	{
+		m_cache->insert(board, moves);
+	}
+	return moves;
+}
+
+RankedMoves MatchingGameExercise::calculateMovesForBoardUncached(const Board& board) const
+{
+	return calculateMovesForBoard<UniqueCellScoringPolicy>(board);
 }
 
 Move MatchingGameExercise::calculateBestMoveForBoard(const Board& board)
 {
-	// Valid moves, ordered by calculated score in ascending order
-	RankedMoves potentialMoves = calculateMovesForBoard(board);
-
-	if (potentialMoves.size() > 0)
+	bool foundMove = false;
+	Move bestMove;
+	if (m_cache)
 	{
-		auto bestMoves = potentialMoves.rbegin();
-		Move bestMove = bestMoves->second.front(); // Pick the first valid scoring move
-		return bestMove;
+		// Use the full ranking so that repeated queries for this board can be answered from the cache
+		auto potentialMoves = findOrCalculateMovesForBoard(board);
+		if (potentialMoves->size() > 0)
+		{
+			bestMove = potentialMoves->rbegin()->second.front(); // Pick the first valid scoring move
+			foundMove = true;
+		}
 	}
 	else
+	{
+		// Only the single best move is needed, so keep that alone rather than ranking every scoring move
+		TopRankedMoves<1> bestMoves = calculateTopMovesForBoard<1>(board);
+		if (!bestMoves.empty())
+		{
+			bestMove = bestMoves.getBest().move;
+			foundMove = true;
+		}
+	}
+
+	if (!foundMove)
 	{
 		// No scoring moves were found, but we cannot perform a swap if there are no matches
 		// TODO: Alter function to return a bool to denote success
 		throw std::logic_error("No valid moves can be performed");
 	}
+	return bestMove;
 }
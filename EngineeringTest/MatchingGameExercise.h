@@ -2,10 +2,43 @@
 
 #include "MatchingGameDecl.h"
 
+#include <functional>
+#include <memory>
+
+class RankedMovesCache;
+
 class MatchingGameExercise
 {
 public:
-	Board beginGame(int width, int height);
+	// colorCount limits generated jewels to the first N kinds, from Red up to Violet
+	Board beginGame(int width, int height, int colorCount = Violet);
+	// As above, drawing from the given random source instead of rand() so several games can be generated in parallel
+	Board beginGame(int width, int height, int colorCount, const std::function<int()>& nextRandom);
 	RankedMoves calculateMovesForBoard(const Board& board);
+	// As above, but shares the ranking held by the cache instead of returning a copy of it
+	std::shared_ptr<const RankedMoves> findOrCalculateMovesForBoard(const Board& board);
+	// Ranks moves under another scoring policy, such as those in MatchingGameScoring.h. The cache only holds
+	//  rankings under the default policy, so these are always evaluated in full
+	template <typename ScoringPolicy>
+	RankedMoves calculateMovesForBoard(const Board& board) const
+	{
+		// Valid moves ordered by calculated score in ascending order
+		RankedMoves potentialMoves;
+		bool hasMatchesBeforeMove = hasMatchesOnBoard(board);
+		forEachCandidateMoveForBoard(board, [&](const Move& move)
+		{
+			rankMoveForBoard<ScoringPolicy>(move, board, potentialMoves, hasMatchesBeforeMove);
+			return true;
+		});
+		return potentialMoves;
+	}
 	Move calculateBestMoveForBoard(const Board& board);
+
+	// Optional cache of previously evaluated boards, which may be shared between several instances and threads
+	void setRankedMovesCache(std::shared_ptr<RankedMovesCache> cache) { m_cache = std::move(cache); }
+
+private:
+	RankedMoves calculateMovesForBoardUncached(const Board& board) const;
+
+	std::shared_ptr<RankedMovesCache> m_cache;
 };
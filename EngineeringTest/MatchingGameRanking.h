@@ -0,0 +1,155 @@
+#pragma once
+
+#include "MatchingGameDecl.h"
+
+#include <algorithm>
+#include <array>
+
+struct ScoredMove
+{
+	int score;
+	int sequence; // Traversal order, used so that earlier moves win ties as with RankedMoves
+	Move move;
+};
+
+// Keeps only the K highest scoring moves in a fixed-size inline heap, without allocating.
+// Moves are streamed in traversal order; on equal scores the earliest move is kept
+template <size_t K>
+class TopRankedMoves
+{
+	static_assert(K > 0, "TopRankedMoves must keep at least one move");
+
+public:
+	TopRankedMoves() :
+		m_count(0),
+		m_nextSequence(0)
+	{
+	}
+
+	// Score a candidate must exceed to be kept. Non-scoring moves are never kept
+	int getThreshold() const { return (m_count < K) ? 0 : m_entries.front().score; }
+
+	// Threshold pruning: a candidate whose score cannot exceed this upper bound need not be evaluated
+	bool canImprove(int scoreUpperBound) const { return scoreUpperBound > getThreshold(); }
+
+	// Counts the candidate towards traversal order even when it is rejected
+	bool tryAdd(int score, const Move& move)
+	{
+		int sequence = m_nextSequence++;
+		if (score <= getThreshold())
+		{
+			return false;
+		}
+
+		ScoredMove entry = { score, sequence, move };
+		if (m_count < K)
+		{
+			m_entries[m_count++] = entry;
+			std::push_heap(m_entries.begin(), m_entries.begin() + m_count, isBetter);
+		}
+		else
+		{
+			// Replace the worst kept move, which the heap keeps at the front
+			std::pop_heap(m_entries.begin(), m_entries.end(), isBetter);
+			m_entries.back() = entry;
+			std::push_heap(m_entries.begin(), m_entries.end(), isBetter);
+		}
+		return true;
+	}
+
+	// Records a candidate that was pruned without being scored, keeping the traversal order intact
+	void skip() { m_nextSequence++; }
+
+	bool empty() const { return m_count == 0; }
+	size_t size() const { return m_count; }
+	bool isFull() const { return m_count == K; }
+
+	// Kept moves ordered from best to worst
+	std::vector<ScoredMove> getSortedMoves() const
+	{
+		std::vector<ScoredMove> sortedMoves(m_entries.begin(), m_entries.begin() + m_count);
+		std::sort(sortedMoves.begin(), sortedMoves.end(), isBetter);
+		return sortedMoves;
+	}
+
+	const ScoredMove& getBest() const
+	{
+		return *std::min_element(m_entries.begin(), m_entries.begin() + m_count, isBetter);
+	}
+
+private:
+	// Heap ordering places the worst entry at the front, as no other entry is worse than it
+	static bool isBetter(const ScoredMove& lhs, const ScoredMove& rhs)
+	{
+		return lhs.score > rhs.score || (lhs.score == rhs.score && lhs.sequence < rhs.sequence);
+	}
+
+	std::array<ScoredMove, K> m_entries;
+	size_t m_count;
+	int m_nextSequence;
+};
+
+// Cheap upper bound on the score a move can achieve. Swapping two jewels of the same kind cannot
+//  change the board, so scores nothing unless the board already held matches, and otherwise the scoring policy
+//  bounds the score by the number of jewels on the board
+template <typename ScoringPolicy = UniqueCellScoringPolicy>
+inline int calculateScoreUpperBoundForMove(const Move& move, const Board& board, int jewelCount, bool hasMatchesBeforeMove = true)
+{
+	int targetX, targetY;
+	getIndexAfterMove(move, targetX, targetY);
+	if (!hasMatchesBeforeMove && board.getJewel(move.x, move.y) == board.getJewel(targetX, targetY))
+	{
+		return 0;
+	}
+	return ScoringPolicy::calculateScoreUpperBound(jewelCount);
+}
+
+// Returns true if the move was kept by the ranking
+template <size_t K, typename ScoringPolicy = UniqueCellScoringPolicy>
+inline bool rankMoveForBoard(const Move& move, const Board& board, int scoreUpperBound, TopRankedMoves<K>& out_ranking, bool hasMatchesBeforeMove = true)
+{
+	if (out_ranking.canImprove(scoreUpperBound))
+	{
+		return out_ranking.tryAdd(calculateScoreAfterMoveForBoard<ScoringPolicy>(move, board, hasMatchesBeforeMove), move);
+	}
+	out_ranking.skip();
+	return false;
+}
+
+inline int countJewelsOnBoard(const Board& board)
+{
+	int jewelCount = 0;
+	for (int y = 0; y < board.getHeight(); y++)
+	{
+		for (int x = 0; x < board.getWidth(); x++)
+		{
+			jewelCount += (board.getJewel(x, y) != Empty) ? 1 : 0;
+		}
+	}
+	return jewelCount;
+}
+
+// Streams every candidate move through a TopRankedMoves ranking, calling 'visitor(ranking, wasKept)' after each one.
+// The search stops early if the visitor returns false, or as soon as the ranking is full with moves that reach
+//  the scoring policy's upper bound, as no remaining move could beat them
+template <size_t K, typename ScoringPolicy = UniqueCellScoringPolicy, typename RankingVisitor>
+inline TopRankedMoves<K> calculateTopMovesForBoard(const Board& board, RankingVisitor&& visitor)
+{
+	int jewelCount = countJewelsOnBoard(board);
+	int maxScore = ScoringPolicy::calculateScoreUpperBound(jewelCount);
+	bool hasMatchesBeforeMove = hasMatchesOnBoard(board);
+	TopRankedMoves<K> ranking;
+	forEachCandidateMoveForBoard(board, [&](const Move& move)
+	{
+		int scoreUpperBound = calculateScoreUpperBoundForMove<ScoringPolicy>(move, board, jewelCount, hasMatchesBeforeMove);
+		bool wasKept = rankMoveForBoard<K, ScoringPolicy>(move, board, scoreUpperBound, ranking, hasMatchesBeforeMove);
+		return visitor(static_cast<const TopRankedMoves<K>&>(ranking), wasKept) && ranking.canImprove(maxScore);
+	});
+	return ranking;
+}
+
+template <size_t K, typename ScoringPolicy = UniqueCellScoringPolicy>
+inline TopRankedMoves<K> calculateTopMovesForBoard(const Board& board)
+{
+	return calculateTopMovesForBoard<K, ScoringPolicy>(board, [](const TopRankedMoves<K>&, bool) { return true; });
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "MatchingGameDecl.h"
+
+#include <algorithm>
+#include <climits>
+
+// Additional scoring policies for calculateScoreAfterMoveForBoard, calculateMovesForBoard and calculateTopMovesForBoard.
+// See UniqueCellScoringPolicy for the interface each policy provides
+
+inline int clampScoreUpperBound(long long score)
+{
+	return (int)std::min(score, (long long)INT_MAX);
+}
+
+// Each cascade step is worth its unique matched cells multiplied by its depth plus one, so later cascades score more
+struct CascadeMultiplierScoringPolicy
+{
+	static int scoreMatches(const MatchedCellsCollection& matches, int cascadeDepth, const Board&, const MatchingAllocator& allocator)
+	{
+		return countUniqueMatchedCells(matches, allocator) * (cascadeDepth + 1);
+	}
+
+	// Every step clears at least NumberOfColorsToMatch jewels, limiting how deep a cascade can go
+	static int calculateScoreUpperBound(int jewelCount)
+	{
+		return clampScoreUpperBound((long long)jewelCount * (jewelCount / NumberOfColorsToMatch + 1));
+	}
+};
+
+// Unique matched cells, plus a bonus for every cell a single match has beyond the minimum length
+template <int BonusPerExtraCell>
+struct MatchLengthBonusScoringPolicy
+{
+	static int scoreMatches(const MatchedCellsCollection& matches, int, const Board&, const MatchingAllocator& allocator)
+	{
+		int score = countUniqueMatchedCells(matches, allocator);
+		for (const auto& match : matches)
+		{
+			score += BonusPerExtraCell * std::max((int)match.size() - NumberOfColorsToMatch, 0);
+		}
+		return score;
+	}
+
+	// The two matches formed by a move may share cells, so each cell can count towards at most two bonuses
+	static int calculateScoreUpperBound(int jewelCount)
+	{
+		return clampScoreUpperBound((long long)jewelCount * (1 + 2 * BonusPerExtraCell));
+	}
+};
+
+// Unique matched cells, plus a bonus for every matched jewel of one special kind
+template <JewelKind SpecialKind, int BonusPerSpecialCell>
+struct SpecialJewelScoringPolicy
+{
+	static int scoreMatches(const MatchedCellsCollection& matches, int, const Board& board, const MatchingAllocator& allocator)
+	{
+		BoardCellCollection uniqueCells(allocator);
+		for (const auto& match : matches)
+		{
+			uniqueCells.insert(match.begin(), match.end());
+		}
+
+		int score = (int)uniqueCells.size();
+		for (const auto& cell : uniqueCells)
+		{
+			if (board.getJewel(cell.x, cell.y) == SpecialKind)
+			{
+				score += BonusPerSpecialCell;
+			}
+		}
+		return score;
+	}
+
+	static int calculateScoreUpperBound(int jewelCount)
+	{
+		return clampScoreUpperBound((long long)jewelCount * (1 + BonusPerSpecialCell));
+	}
+};
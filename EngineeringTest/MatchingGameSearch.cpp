@@ -0,0 +1,195 @@
+#include "MatchingGameSearch.h"
+
+#include "MatchingGameRanking.h"
+
+#include <algorithm>
+
+MoveSearchJob::MoveSearchJob(const Board& board, MoveSearchClock::time_point deadline, MoveSearchCallback onBestMoveImproved) :
+	m_board(board),
+	m_deadline(deadline),
+	m_onBestMoveImproved(std::move(onBestMoveImproved)),
+	m_cancelRequested(false),
+	m_status(MoveSearchStatus::Queued),
+	m_result()
+{
+	int width = board.getWidth();
+	int height = board.getHeight();
+	m_result.movesTotal = std::max(width * (height - 1), 0) + std::max((width - 1) * height, 0);
+}
+
+MoveSearchStatus MoveSearchJob::getStatus() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_status;
+}
+
+bool MoveSearchJob::isFinished() const
+{
+	MoveSearchStatus status = getStatus();
+	return status != MoveSearchStatus::Queued && status != MoveSearchStatus::Running;
+}
+
+MoveSearchResult MoveSearchJob::getBestSoFar() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_result;
+}
+
+MoveSearchResult MoveSearchJob::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_finished.wait(lock, [this]() { return m_status != MoveSearchStatus::Queued && m_status != MoveSearchStatus::Running; });
+	return m_result;
+}
+
+bool MoveSearchJob::waitUntil(MoveSearchClock::time_point time)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_finished.wait_until(lock, time, [this]() { return m_status != MoveSearchStatus::Queued && m_status != MoveSearchStatus::Running; });
+}
+
+void MoveSearchJob::run()
+{
+	// Jobs cancelled or out of time while queued finish without evaluating any moves
+	if (m_cancelRequested || MoveSearchClock::now() >= m_deadline)
+	{
+		finish(m_cancelRequested ? MoveSearchStatus::Cancelled : MoveSearchStatus::DeadlineExpired);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_status = MoveSearchStatus::Running;
+	}
+
+	// Moves are ranked in the same order and with the same tie-breaking as calculateBestMoveForBoard,
+	//  so a search that runs to completion returns the same move
+	MoveSearchStatus stoppedStatus = MoveSearchStatus::Completed;
+	calculateTopMovesForBoard<1>(m_board, [this, &stoppedStatus](const TopRankedMoves<1>& ranking, bool wasKept)
+	{
+		MoveSearchResult result;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_result.movesEvaluated++;
+			if (wasKept)
+			{
+				const ScoredMove& best = ranking.getBest();
+				m_result.foundMove = true;
+				m_result.bestMove = best.move;
+				m_result.bestScore = best.score;
+			}
+			result = m_result;
+		}
+		if (wasKept && m_onBestMoveImproved)
+		{
+			m_onBestMoveImproved(result);
+		}
+
+		if (m_cancelRequested)
+		{
+			stoppedStatus = MoveSearchStatus::Cancelled;
+		}
+		else if (MoveSearchClock::now() >= m_deadline)
+		{
+			stoppedStatus = MoveSearchStatus::DeadlineExpired;
+		}
+		return stoppedStatus == MoveSearchStatus::Completed;
+	});
+
+	// A search that stopped on its final move, or was pruned early, has still considered every move
+	finish(stoppedStatus);
+}
+
+void MoveSearchJob::finish(MoveSearchStatus status)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (status == MoveSearchStatus::Completed || m_result.movesEvaluated == m_result.movesTotal)
+		{
+			m_result.movesEvaluated = m_result.movesTotal;
+			status = MoveSearchStatus::Completed;
+		}
+		m_status = status;
+	}
+	m_finished.notify_all();
+}
+
+MoveSearchService::MoveSearchService(unsigned int threadCount) :
+	m_isStopping(false)
+{
+	if (threadCount == 0)
+	{
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		m_workers.emplace_back(&MoveSearchService::runWorker, this);
+	}
+}
+
+MoveSearchService::~MoveSearchService()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopping = true;
+		for (auto& job : m_pendingJobs)
+		{
+			job->cancel();
+		}
+		for (auto& job : m_runningJobs)
+		{
+			job->cancel();
+		}
+	}
+	m_jobAvailable.notify_all();
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+std::shared_ptr<MoveSearchJob> MoveSearchService::submit(const Board& board, MoveSearchCallback onBestMoveImproved)
+{
+	return submit(board, MoveSearchClock::time_point::max(), std::move(onBestMoveImproved));
+}
+
+std::shared_ptr<MoveSearchJob> MoveSearchService::submit(const Board& board, MoveSearchClock::time_point deadline, MoveSearchCallback onBestMoveImproved)
+{
+	auto job = std::make_shared<MoveSearchJob>(board, deadline, std::move(onBestMoveImproved));
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_isStopping)
+		{
+			// No worker is left to run it, so finish the job as cancelled straight away
+			job->cancel();
+			job->run();
+			return job;
+		}
+		m_pendingJobs.push_back(job);
+	}
+	m_jobAvailable.notify_one();
+	return job;
+}
+
+void MoveSearchService::runWorker()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		// Remaining queued jobs are still drained when stopping; as they are cancelled, each finishes immediately
+		m_jobAvailable.wait(lock, [this]() { return !m_pendingJobs.empty() || m_isStopping; });
+		if (m_pendingJobs.empty())
+		{
+			break;
+		}
+		std::shared_ptr<MoveSearchJob> job = std::move(m_pendingJobs.front());
+		m_pendingJobs.pop_front();
+		m_runningJobs.push_back(job);
+		lock.unlock();
+
+		job->run();
+
+		lock.lock();
+		m_runningJobs.erase(std::find(m_runningJobs.begin(), m_runningJobs.end(), job));
+	}
+}
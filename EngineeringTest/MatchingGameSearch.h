@@ -0,0 +1,97 @@
+#pragma once
+
+#include "MatchingGameDecl.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using MoveSearchClock = std::chrono::steady_clock;
+
+enum class MoveSearchStatus
+{
+	Queued,
+	Running,
+	Completed, // Every candidate move was considered, so the best move matches calculateBestMoveForBoard
+	Cancelled,
+	DeadlineExpired
+};
+
+struct MoveSearchResult
+{
+	bool foundMove;
+	Move bestMove;
+	int bestScore;
+	int movesEvaluated; // Candidate swaps considered so far, including those pruned without being scored
+	int movesTotal;
+};
+
+// Called on the search thread each time a better move is found
+using MoveSearchCallback = std::function<void(const MoveSearchResult&)>;
+
+// Handle to a single best-move search. The best move found so far can be read or waited on at any time,
+//  and remains valid after the search is cancelled or runs out of time
+class MoveSearchJob
+{
+public:
+	MoveSearchJob(const Board& board, MoveSearchClock::time_point deadline, MoveSearchCallback onBestMoveImproved);
+
+	// Stops the search after the move currently being evaluated, keeping the best move found so far
+	void cancel() { m_cancelRequested = true; }
+
+	MoveSearchStatus getStatus() const;
+	bool isFinished() const;
+	MoveSearchResult getBestSoFar() const;
+
+	// Blocks until the search finishes, returning its final result
+	MoveSearchResult wait();
+	// Returns false if the search is still running at 'time'
+	bool waitUntil(MoveSearchClock::time_point time);
+
+	// Runs the search on the calling thread; used by MoveSearchService workers
+	void run();
+
+private:
+	void finish(MoveSearchStatus status);
+
+	Board m_board;
+	MoveSearchClock::time_point m_deadline;
+	MoveSearchCallback m_onBestMoveImproved;
+	std::atomic<bool> m_cancelRequested;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_finished;
+	MoveSearchStatus m_status;
+	MoveSearchResult m_result;
+};
+
+// Runs submitted move searches on a fixed pool of worker threads, in submission order.
+// Time spent queued counts towards a job's deadline, so a request handler can pass its own latency budget
+class MoveSearchService
+{
+public:
+	explicit MoveSearchService(unsigned int threadCount = 0); // Zero uses every available hardware thread
+	~MoveSearchService(); // Cancels outstanding searches and waits for the workers to finish
+
+	MoveSearchService(const MoveSearchService&) = delete;
+	MoveSearchService& operator = (const MoveSearchService&) = delete;
+
+	std::shared_ptr<MoveSearchJob> submit(const Board& board, MoveSearchCallback onBestMoveImproved = nullptr);
+	std::shared_ptr<MoveSearchJob> submit(const Board& board, MoveSearchClock::time_point deadline, MoveSearchCallback onBestMoveImproved = nullptr);
+
+private:
+	void runWorker();
+
+	std::mutex m_mutex;
+	std::condition_variable m_jobAvailable;
+	std::deque<std::shared_ptr<MoveSearchJob>> m_pendingJobs;
+	std::vector<std::shared_ptr<MoveSearchJob>> m_runningJobs;
+	std::vector<std::thread> m_workers;
+	bool m_isStopping;
+};
@@ -0,0 +1,142 @@
+#include "MatchingGameSimulator.h"
+
+#include "MatchingGameExercise.h"
+#include "MatchingGameRanking.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// Fill every empty cell with a jewel from the spawn stream. Spawned jewels may form new matches, which cascade
+void refillEmptyCells(Board& out_board, int colorCount, std::mt19937& spawnStream)
+{
+	std::uniform_int_distribution<int> kindDistribution(Red, colorCount);
+	for (int y = 0; y < out_board.getHeight(); y++)
+	{
+		for (int x = 0; x < out_board.getWidth(); x++)
+		{
+			if (out_board.getJewel(x, y) == Empty)
+			{
+				out_board.setJewel(x, y, (JewelKind)kindDistribution(spawnStream));
+			}
+		}
+	}
+}
+
+} // namespace
+
+MatchingGameSimulator::MatchingGameSimulator(const SimulationConfig& config) :
+	m_config(config)
+{
+}
+
+GameResult MatchingGameSimulator::playGame(const SimulationConfig& config, unsigned int gameSeed)
+{
+	GameResult result = {};
+	std::mt19937 spawnStream(gameSeed);
+	MatchingGameExercise matchingGame;
+	Board board = matchingGame.beginGame(config.boardWidth, config.boardHeight, config.colorCount, [&spawnStream]() { return (int)(spawnStream() >> 1); });
+
+	while (result.movesPlayed < config.maxMovesPerGame)
+	{
+		// Equivalent to calculateBestMoveForBoard, without using an exception to signal the end of the game
+		TopRankedMoves<1> bestMoves = calculateTopMovesForBoard<1>(board);
+		if (bestMoves.empty())
+		{
+			break;
+		}
+
+		// Apply the move in the same way as calculateScoreAfterMoveForBoard, refilling the board after each step
+		Move bestMove = bestMoves.getBest().move;
+		performMoveForBoard(bestMove, board);
+		MatchedCellsCollection matches = findMatchesAfterMoveForBoard(bestMove, board);
+		resolveMatchesForBoard(matches, board);
+
+		int cascadeDepth = -1; // The first iteration is the move's own match
+		while (!matches.empty())
+		{
+			result.score += countUniqueMatchedCells(matches, MatchingAllocator());
+			cascadeDepth++;
+
+			repopulateBoardAfterMatches(matches, board);
+			refillEmptyCells(board, config.colorCount, spawnStream);
+			matches = resolveCascadingMatches(board);
+		}
+
+		result.movesPlayed++;
+		result.cascadeSteps += std::max(cascadeDepth, 0);
+		result.maxCascadeDepth = std::max(result.maxCascadeDepth, cascadeDepth);
+	}
+
+	return result;
+}
+
+SimulationStats MatchingGameSimulator::run()
+{
+	int gameCount = std::max(m_config.gameCount, 0);
+	m_gameResults.assign(gameCount, GameResult());
+
+	unsigned int threadCount = m_config.threadCount;
+	if (threadCount == 0)
+	{
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	threadCount = std::min(threadCount, (unsigned int)std::max(gameCount, 1));
+
+	// Games are claimed one at a time from a shared counter, balancing long and short games across threads
+	std::atomic<int> nextGame(0);
+	auto worker = [this, gameCount, &nextGame]()
+	{
+		for (int gameIndex = nextGame++; gameIndex < gameCount; gameIndex = nextGame++)
+		{
+			unsigned int gameSeed = (unsigned int)mixHash(((uint64_t)m_config.seed << 32) | (uint32_t)gameIndex);
+			m_gameResults[gameIndex] = playGame(m_config, gameSeed);
+		}
+	};
+
+	auto start = Clock::now();
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		workers.emplace_back(worker);
+	}
+	for (auto& thread : workers)
+	{
+		thread.join();
+	}
+	double elapsedS = std::chrono::duration<double>(Clock::now() - start).count();
+
+	SimulationStats stats = {};
+	stats.gamesPlayed = gameCount;
+	stats.elapsedS = elapsedS;
+	if (gameCount > 0)
+	{
+		long long totalCascadeSteps = 0;
+		stats.minScore = m_gameResults.front().score;
+		for (const auto& game : m_gameResults)
+		{
+			stats.totalMoves += game.movesPlayed;
+			stats.totalScore += game.score;
+			stats.minScore = std::min(stats.minScore, game.score);
+			stats.maxScore = std::max(stats.maxScore, game.score);
+			stats.maxCascadeDepth = std::max(stats.maxCascadeDepth, game.maxCascadeDepth);
+			totalCascadeSteps += game.cascadeSteps;
+		}
+		stats.meanScore = (double)stats.totalScore / gameCount;
+		stats.meanMovesPerGame = (double)stats.totalMoves / gameCount;
+		stats.meanCascadeDepth = (stats.totalMoves > 0) ? (double)totalCascadeSteps / stats.totalMoves : 0.0;
+	}
+	if (elapsedS > 0)
+	{
+		stats.movesPerSecond = stats.totalMoves / elapsedS;
+		stats.gamesPerSecond = gameCount / elapsedS;
+	}
+	return stats;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "MatchingGameDecl.h"
+
+#include <vector>
+
+struct SimulationConfig
+{
+	int boardWidth = 8;
+	int boardHeight = 8;
+	int colorCount = Violet;
+	int gameCount = 1000;
+	int maxMovesPerGame = 1000; // Guards against games that never run out of moves
+	unsigned int seed = 1; // Each game derives its own seed from this and its index, so results are independent of thread count
+	unsigned int threadCount = 0; // Zero uses every available hardware thread
+};
+
+struct GameResult
+{
+	int score;
+	int movesPlayed;
+	int cascadeSteps; // Total cascade steps triggered across all moves, excluding each move's initial match
+	int maxCascadeDepth;
+};
+
+struct SimulationStats
+{
+	int gamesPlayed;
+	long long totalMoves;
+	long long totalScore;
+	int minScore;
+	int maxScore;
+	double meanScore;
+	double meanMovesPerGame;
+	double meanCascadeDepth; // Average cascade steps per move
+	int maxCascadeDepth;
+	double elapsedS;
+	double movesPerSecond;
+	double gamesPerSecond;
+};
+
+// Plays complete matching games by repeatedly applying the best move, resolving cascades and refilling
+//  emptied cells from a seeded spawn stream until no scoring moves remain
+class MatchingGameSimulator
+{
+public:
+	explicit MatchingGameSimulator(const SimulationConfig& config);
+
+	// Plays every configured game across worker threads, blocking until all have finished
+	SimulationStats run();
+	const std::vector<GameResult>& getGameResults() const { return m_gameResults; }
+
+	static GameResult playGame(const SimulationConfig& config, unsigned int gameSeed);
+
+private:
+	SimulationConfig m_config;
+	std::vector<GameResult> m_gameResults;
+};
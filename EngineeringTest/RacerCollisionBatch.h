@@ -0,0 +1,344 @@
+#pragma once
+
+#include "RacingGameExercise.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <math.h>
+#include <set>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define RACER_COLLISION_SIMD_WIDTH 8
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RACER_COLLISION_SIMD_WIDTH 4
+#else
+#define RACER_COLLISION_SIMD_WIDTH 1
+#endif
+
+enum class RacerShapeKind : uint8_t
+{
+	Sphere, // Radius stored in extentX
+	Box, // Axis-aligned half extents
+	Custom // Tested with Racer::collidesWith
+};
+
+// Collision shapes for every racer in structure-of-arrays layout, indexed the same as the racer collection
+struct RacerCollisionShapes
+{
+	void resize(size_t count)
+	{
+		centerX.resize(count);
+		centerY.resize(count);
+		centerZ.resize(count);
+		extentX.resize(count);
+		extentY.resize(count);
+		extentZ.resize(count);
+		kinds.resize(count, RacerShapeKind::Custom);
+	}
+
+	void setSphere(size_t index, float x, float y, float z, float radius)
+	{
+		setShape(index, RacerShapeKind::Sphere, x, y, z, radius, radius, radius);
+	}
+
+	void setBox(size_t index, float x, float y, float z, float halfX, float halfY, float halfZ)
+	{
+		setShape(index, RacerShapeKind::Box, x, y, z, halfX, halfY, halfZ);
+	}
+
+	void setCustom(size_t index)
+	{
+		kinds[index] = RacerShapeKind::Custom;
+	}
+
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> extentX;
+	std::vector<float> extentY;
+	std::vector<float> extentZ;
+	std::vector<RacerShapeKind> kinds;
+
+private:
+	void setShape(size_t index, RacerShapeKind kind, float x, float y, float z, float halfX, float halfY, float halfZ)
+	{
+		kinds[index] = kind;
+		centerX[index] = x;
+		centerY[index] = y;
+		centerZ[index] = z;
+		extentX[index] = halfX;
+		extentY[index] = halfY;
+		extentZ[index] = halfZ;
+	}
+};
+
+struct RacerPair
+{
+	uint32_t first;
+	uint32_t second;
+};
+
+inline bool operator < (const RacerPair& lhs, const RacerPair& rhs)
+{
+	return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+}
+
+// Collision masks hold one bit per pair, bit (i % 64) of word (i / 64)
+inline void resizeCollisionMask(size_t pairCount, std::vector<uint64_t>& out_mask)
+{
+	out_mask.assign((pairCount + 63) / 64, 0);
+}
+
+inline bool isPairColliding(const std::vector<uint64_t>& mask, size_t pairIndex)
+{
+	return ((mask[pairIndex / 64] >> (pairIndex % 64)) & 1) != 0;
+}
+
+namespace RacerCollisionKernels
+{
+
+inline bool testSpherePair(const RacerCollisionShapes& shapes, const RacerPair& pair)
+{
+	float dx = shapes.centerX[pair.first] - shapes.centerX[pair.second];
+	float dy = shapes.centerY[pair.first] - shapes.centerY[pair.second];
+	float dz = shapes.centerZ[pair.first] - shapes.centerZ[pair.second];
+	float radii = shapes.extentX[pair.first] + shapes.extentX[pair.second];
+	return dx*dx + dy*dy + dz*dz <= radii*radii;
+}
+
+inline bool testBoxPair(const RacerCollisionShapes& shapes, const RacerPair& pair)
+{
+	return fabsf(shapes.centerX[pair.first] - shapes.centerX[pair.second]) <= shapes.extentX[pair.first] + shapes.extentX[pair.second]
+		&& fabsf(shapes.centerY[pair.first] - shapes.centerY[pair.second]) <= shapes.extentY[pair.first] + shapes.extentY[pair.second]
+		&& fabsf(shapes.centerZ[pair.first] - shapes.centerZ[pair.second]) <= shapes.extentZ[pair.first] + shapes.extentZ[pair.second];
+}
+
+#if RACER_COLLISION_SIMD_WIDTH == 8
+using FloatBatch = __m256;
+inline FloatBatch gather(const std::vector<float>& values, const RacerPair* pairs, uint32_t RacerPair::* member)
+{
+	return _mm256_setr_ps(values[pairs[0].*member], values[pairs[1].*member], values[pairs[2].*member], values[pairs[3].*member],
+		values[pairs[4].*member], values[pairs[5].*member], values[pairs[6].*member], values[pairs[7].*member]);
+}
+inline FloatBatch add(FloatBatch lhs, FloatBatch rhs) { return _mm256_add_ps(lhs, rhs); }
+inline FloatBatch sub(FloatBatch lhs, FloatBatch rhs) { return _mm256_sub_ps(lhs, rhs); }
+inline FloatBatch mul(FloatBatch lhs, FloatBatch rhs) { return _mm256_mul_ps(lhs, rhs); }
+inline FloatBatch lessEqual(FloatBatch lhs, FloatBatch rhs) { return _mm256_cmp_ps(lhs, rhs, _CMP_LE_OQ); }
+inline FloatBatch bitAnd(FloatBatch lhs, FloatBatch rhs) { return _mm256_and_ps(lhs, rhs); }
+inline FloatBatch absolute(FloatBatch value) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), value); }
+inline int toBits(FloatBatch mask) { return _mm256_movemask_ps(mask); }
+#elif RACER_COLLISION_SIMD_WIDTH == 4
+using FloatBatch = __m128;
+inline FloatBatch gather(const std::vector<float>& values, const RacerPair* pairs, uint32_t RacerPair::* member)
+{
+	return _mm_setr_ps(values[pairs[0].*member], values[pairs[1].*member], values[pairs[2].*member], values[pairs[3].*member]);
+}
+inline FloatBatch add(FloatBatch lhs, FloatBatch rhs) { return _mm_add_ps(lhs, rhs); }
+inline FloatBatch sub(FloatBatch lhs, FloatBatch rhs) { return _mm_sub_ps(lhs, rhs); }
+inline FloatBatch mul(FloatBatch lhs, FloatBatch rhs) { return _mm_mul_ps(lhs, rhs); }
+inline FloatBatch lessEqual(FloatBatch lhs, FloatBatch rhs) { return _mm_cmple_ps(lhs, rhs); }
+inline FloatBatch bitAnd(FloatBatch lhs, FloatBatch rhs) { return _mm_and_ps(lhs, rhs); }
+inline FloatBatch absolute(FloatBatch value) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), value); }
+inline int toBits(FloatBatch mask) { return _mm_movemask_ps(mask); }
+#endif
+
+} // namespace RacerCollisionKernels
+
+// Tests sphere pairs several at a time, setting the bit for each overlapping pair in out_mask
+inline void testSpherePairs(const RacerCollisionShapes& shapes, const RacerPair* pairs, size_t pairCount, uint64_t* out_mask)
+{
+	using namespace RacerCollisionKernels;
+	size_t i = 0;
+#if RACER_COLLISION_SIMD_WIDTH > 1
+	// The batch width divides 64, so each batch's bits land within a single mask word
+	for (; i + RACER_COLLISION_SIMD_WIDTH <= pairCount; i += RACER_COLLISION_SIMD_WIDTH)
+	{
+		const RacerPair* batch = pairs + i;
+		FloatBatch dx = sub(gather(shapes.centerX, batch, &RacerPair::first), gather(shapes.centerX, batch, &RacerPair::second));
+		FloatBatch dy = sub(gather(shapes.centerY, batch, &RacerPair::first), gather(shapes.centerY, batch, &RacerPair::second));
+		FloatBatch dz = sub(gather(shapes.centerZ, batch, &RacerPair::first), gather(shapes.centerZ, batch, &RacerPair::second));
+		FloatBatch radii = add(gather(shapes.extentX, batch, &RacerPair::first), gather(shapes.extentX, batch, &RacerPair::second));
+		FloatBatch distanceSq = add(add(mul(dx, dx), mul(dy, dy)), mul(dz, dz));
+		uint64_t bits = (uint64_t)toBits(lessEqual(distanceSq, mul(radii, radii)));
+		out_mask[i / 64] |= bits << (i % 64);
+	}
+#endif
+	for (; i < pairCount; i++)
+	{
+		if (RacerCollisionKernels::testSpherePair(shapes, pairs[i]))
+		{
+			out_mask[i / 64] |= (uint64_t)1 << (i % 64);
+		}
+	}
+}
+
+// Tests axis-aligned box pairs several at a time, setting the bit for each overlapping pair in out_mask
+inline void testBoxPairs(const RacerCollisionShapes& shapes, const RacerPair* pairs, size_t pairCount, uint64_t* out_mask)
+{
+	using namespace RacerCollisionKernels;
+	size_t i = 0;
+#if RACER_COLLISION_SIMD_WIDTH > 1
+	for (; i + RACER_COLLISION_SIMD_WIDTH <= pairCount; i += RACER_COLLISION_SIMD_WIDTH)
+	{
+		const RacerPair* batch = pairs + i;
+		FloatBatch overlapX = lessEqual(absolute(sub(gather(shapes.centerX, batch, &RacerPair::first), gather(shapes.centerX, batch, &RacerPair::second))),
+			add(gather(shapes.extentX, batch, &RacerPair::first), gather(shapes.extentX, batch, &RacerPair::second)));
+		FloatBatch overlapY = lessEqual(absolute(sub(gather(shapes.centerY, batch, &RacerPair::first), gather(shapes.centerY, batch, &RacerPair::second))),
+			add(gather(shapes.extentY, batch, &RacerPair::first), gather(shapes.extentY, batch, &RacerPair::second)));
+		FloatBatch overlapZ = lessEqual(absolute(sub(gather(shapes.centerZ, batch, &RacerPair::first), gather(shapes.centerZ, batch, &RacerPair::second))),
+			add(gather(shapes.extentZ, batch, &RacerPair::first), gather(shapes.extentZ, batch, &RacerPair::second)));
+		uint64_t bits = (uint64_t)toBits(bitAnd(bitAnd(overlapX, overlapY), overlapZ));
+		out_mask[i / 64] |= bits << (i % 64);
+	}
+#endif
+	for (; i < pairCount; i++)
+	{
+		if (RacerCollisionKernels::testBoxPair(shapes, pairs[i]))
+		{
+			out_mask[i / 64] |= (uint64_t)1 << (i % 64);
+		}
+	}
+}
+
+// Pairs of matching simple shapes are tested in batches, while custom or mixed shapes need Racer::collidesWith
+inline bool isBatchedShapePair(const RacerCollisionShapes& shapes, const RacerPair& pair)
+{
+	RacerShapeKind firstKind = shapes.kinds[pair.first];
+	return firstKind != RacerShapeKind::Custom && firstKind == shapes.kinds[pair.second];
+}
+
+// Narrowphase over candidate pairs from a broadphase. Pairs of matching simple shapes are tested in batches,
+//  while custom or mixed shapes fall back to Racer::collidesWith. Pairs are returned in ascending order
+class RacerNarrowphase
+{
+public:
+	// Colliding pairs among the candidates. isCollidable is read once per racer before any pair is tested
+	void findCollidingPairs(const std::vector<Racer*>& racers, const RacerCollisionShapes& shapes, const std::vector<RacerPair>& candidatePairs, std::vector<RacerPair>& out_collidingPairs)
+	{
+		// Query each racer once, rather than once per pair it appears in
+		m_isCollidable.resize(racers.size());
+		for (size_t i = 0; i < racers.size(); i++)
+		{
+			m_isCollidable[i] = racers[i]->isCollidable() ? 1 : 0;
+		}
+		collectPairs(&racers, shapes, candidatePairs, out_collidingPairs);
+	}
+
+	// Candidates whose simple shapes overlap, plus every custom or mixed pair untested. Neither isCollidable nor
+	//  collidesWith is called, leaving both to be checked as each pair is resolved
+	void findPotentiallyCollidingPairs(const RacerCollisionShapes& shapes, const std::vector<RacerPair>& candidatePairs, std::vector<RacerPair>& out_pairs)
+	{
+		collectPairs(nullptr, shapes, candidatePairs, out_pairs);
+	}
+
+private:
+	using PairKernel = void (*)(const RacerCollisionShapes&, const RacerPair*, size_t, uint64_t*);
+
+	// When 'racers' is given, pairs including a racer that is not collidable are skipped and custom pairs are tested
+	void collectPairs(const std::vector<Racer*>* racers, const RacerCollisionShapes& shapes, const std::vector<RacerPair>& candidatePairs, std::vector<RacerPair>& out_pairs)
+	{
+		out_pairs.clear();
+		m_spherePairs.clear();
+		m_boxPairs.clear();
+		for (const auto& pair : candidatePairs)
+		{
+			if (racers != nullptr && (!m_isCollidable[pair.first] || !m_isCollidable[pair.second]))
+			{
+				continue;
+			}
+			if (isBatchedShapePair(shapes, pair))
+			{
+				(shapes.kinds[pair.first] == RacerShapeKind::Sphere ? m_spherePairs : m_boxPairs).push_back(pair);
+			}
+			else if (racers == nullptr || (*racers)[pair.first]->collidesWith((*racers)[pair.second]))
+			{
+				out_pairs.push_back(pair);
+			}
+		}
+
+		appendCollidingPairs(m_spherePairs, testSpherePairs, shapes, out_pairs);
+		appendCollidingPairs(m_boxPairs, testBoxPairs, shapes, out_pairs);
+		std::sort(out_pairs.begin(), out_pairs.end());
+	}
+
+	void appendCollidingPairs(const std::vector<RacerPair>& pairs, PairKernel kernel, const RacerCollisionShapes& shapes, std::vector<RacerPair>& out_collidingPairs)
+	{
+		resizeCollisionMask(pairs.size(), m_mask);
+		kernel(shapes, pairs.data(), pairs.size(), m_mask.data());
+		for (size_t word = 0; word < m_mask.size(); word++)
+		{
+			// Visit only the set bits of each word
+			for (uint64_t bits = m_mask[word]; bits != 0; bits &= bits - 1)
+			{
+				size_t bit = 0;
+				while (((bits >> bit) & 1) == 0)
+				{
+					bit++;
+				}
+				out_collidingPairs.push_back(pairs[word * 64 + bit]);
+			}
+		}
+	}
+
+	// Scratch buffers, reused between ticks to avoid reallocating
+	std::vector<uint8_t> m_isCollidable;
+	std::vector<RacerPair> m_spherePairs;
+	std::vector<RacerPair> m_boxPairs;
+	std::vector<uint64_t> m_mask;
+};
+
+// Every pair (i, j) with i < j, for use when no broadphase is available
+inline void buildAllRacerPairs(size_t racerCount, std::vector<RacerPair>& out_pairs)
+{
+	out_pairs.clear();
+	for (uint32_t i = 0; i < (uint32_t)racerCount; i++)
+	{
+		for (uint32_t j = i + 1; j < (uint32_t)racerCount; j++)
+		{
+			out_pairs.push_back(RacerPair{ i, j });
+		}
+	}
+}
+
+// Batched equivalent of resolveRacerCollisions. Candidate pairs must have first < second and index both racers and shapes.
+// Potential collisions are resolved in the same order as the nested loops of resolveRacerCollisions, testing isCollidable
+//  as each pair is reached, so explosions are reported identically even if onRacerExplodes makes a racer uncollidable
+inline void resolveRacerCollisionsBatched(std::vector<Racer*>& racers, const RacerCollisionShapes& shapes, const std::vector<RacerPair>& candidatePairs,
+	RacerNarrowphase& narrowphase, const std::function<void(Racer*)>& onRacerRemoved = nullptr)
+{
+	std::vector<RacerPair> potentialPairs;
+	narrowphase.findPotentiallyCollidingPairs(shapes, candidatePairs, potentialPairs);
+
+	std::set<int> entriesToRemove;
+	size_t lhsIndex = racers.size();
+	bool isLhsCollidable = false;
+	for (const auto& pair : potentialPairs)
+	{
+		Racer* lhs = racers[pair.first];
+		Racer* rhs = racers[pair.second];
+		if (pair.first != lhsIndex)
+		{
+			// Like the outer loop of resolveRacerCollisions, lhs is checked once before any of its own pairs
+			lhsIndex = pair.first;
+			isLhsCollidable = lhs->isCollidable();
+		}
+		if (!isLhsCollidable || !rhs->isCollidable())
+		{
+			continue;
+		}
+		if (!isBatchedShapePair(shapes, pair) && !lhs->collidesWith(rhs))
+		{
+			continue;
+		}
+
+		onRacerExplodes(lhs);
+		onRacerExplodes(rhs);
+		entriesToRemove.insert((int)pair.first);
+		entriesToRemove.insert((int)pair.second);
+	}
+	removeExplodedRacers(entriesToRemove, racers, onRacerRemoved);
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "RacingGameExercise.h"
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace RacerRegistryDetail
+{
+
+// Calls function(std::integral_constant<size_t, I>()) for each index in order, resolving every call at compile time
+template <typename Function, size_t... Indices>
+inline void forEachIndex(Function&& function, std::index_sequence<Indices...>)
+{
+	int expand[] = { 0, (function(std::integral_constant<size_t, Indices>()), 0)... };
+	(void)expand;
+}
+
+template <size_t Count, typename Function>
+inline void forEachIndexReversed(Function&& function)
+{
+	forEachIndex([&function](auto index)
+	{
+		function(std::integral_constant<size_t, Count - 1 - decltype(index)::value>());
+	}, std::make_index_sequence<Count>());
+}
+
+} // namespace RacerRegistryDetail
+
+// Stores each concrete racer type by value in its own contiguous array, so every update, isAlive, isCollidable and
+//  collidesWith call is statically dispatched within a tight loop over a single type.
+// Racer types derive from Racer without virtual functions, hiding its members with their own implementations.
+// collidesWith must accept a pointer to any registered racer type
+template <typename... RacerTypes>
+class RacerRegistry
+{
+public:
+	static const size_t TypeCount = sizeof...(RacerTypes);
+	static_assert(TypeCount > 0, "RacerRegistry needs at least one racer type");
+
+	template <typename RacerType, typename... Args>
+	RacerType& add(Args&&... args)
+	{
+		auto& batch = std::get<std::vector<RacerType>>(m_batches);
+		batch.emplace_back(std::forward<Args>(args)...);
+		return batch.back();
+	}
+
+	template <typename RacerType>
+	std::vector<RacerType>& getBatch() { return std::get<std::vector<RacerType>>(m_batches); }
+
+	size_t size() const
+	{
+		size_t count = 0;
+		RacerRegistryDetail::forEachIndex([this, &count](auto index)
+		{
+			count += std::get<decltype(index)::value>(m_batches).size();
+		}, std::make_index_sequence<TypeCount>());
+		return count;
+	}
+
+	// Same phases as updateRacersV2: update live racers, test every pair for collisions, then remove exploded racers
+	void update(float deltaTimeS)
+	{
+		// TODO: Choose consistent time format
+		float racerUpdateTick = deltaTimeS * 1000.0f;
+
+		// Racers are updated in reverse order, which matches updateRacersV2 when racers were added grouped by type.
+		// The last type's batch is updated first, and each batch from its last racer to its first
+		RacerRegistryDetail::forEachIndexReversed<TypeCount>([this, racerUpdateTick](auto index)
+		{
+			auto& batch = std::get<decltype(index)::value>(m_batches);
+			for (auto it = batch.rbegin(); it != batch.rend(); ++it)
+			{
+				if (it->isAlive())
+				{
+					it->update(racerUpdateTick);
+				}
+			}
+		});
+
+		RacerRegistryDetail::forEachIndex([this](auto index)
+		{
+			auto& exploded = m_explodedFlags[decltype(index)::value];
+			exploded.assign(std::get<decltype(index)::value>(m_batches).size(), 0);
+		}, std::make_index_sequence<TypeCount>());
+
+		// Pairs are visited in the same order as the i < j loop of resolveRacerCollisions over the concatenated batches:
+		//  each racer is tested against the rest of its own batch, then against every racer in the batches after it
+		RacerRegistryDetail::forEachIndex([this](auto lhsIndex)
+		{
+			auto& lhsBatch = std::get<decltype(lhsIndex)::value>(m_batches);
+			for (size_t i = 0; i < lhsBatch.size(); i++)
+			{
+				if (lhsBatch[i].isCollidable())
+				{
+					RacerRegistryDetail::forEachIndex([this, lhsIndex, i](auto rhsIndex)
+					{
+						collideWithBatch<decltype(lhsIndex)::value, decltype(rhsIndex)::value>(i);
+					}, std::make_index_sequence<TypeCount>());
+				}
+			}
+		}, std::make_index_sequence<TypeCount>());
+
+		// Erase exploded racers in place, preserving the order of those remaining
+		RacerRegistryDetail::forEachIndex([this](auto index)
+		{
+			auto& batch = std::get<decltype(index)::value>(m_batches);
+			const auto& exploded = m_explodedFlags[decltype(index)::value];
+			size_t writeIndex = 0;
+			for (size_t readIndex = 0; readIndex < batch.size(); readIndex++)
+			{
+				if (!exploded[readIndex])
+				{
+					if (writeIndex != readIndex)
+					{
+						batch[writeIndex] = std::move(batch[readIndex]);
+					}
+					writeIndex++;
+				}
+			}
+			batch.erase(batch.begin() + writeIndex, batch.end());
+		}, std::make_index_sequence<TypeCount>());
+	}
+
+private:
+	template <size_t LhsIndex, size_t RhsIndex>
+	typename std::enable_if<(LhsIndex > RhsIndex)>::type collideWithBatch(size_t)
+	{
+		// Earlier batches have already tested their racers against this one
+	}
+
+	// Tests racer i of batch LhsIndex against the racers that follow it in batch RhsIndex
+	template <size_t LhsIndex, size_t RhsIndex>
+	typename std::enable_if<(LhsIndex <= RhsIndex)>::type collideWithBatch(size_t i)
+	{
+		auto& lhs = std::get<LhsIndex>(m_batches)[i];
+		auto& rhsBatch = std::get<RhsIndex>(m_batches);
+		auto& rhsExploded = m_explodedFlags[RhsIndex];
+		// Within a single batch, only test each pair in one direction
+		for (size_t j = (LhsIndex == RhsIndex) ? i + 1 : 0; j < rhsBatch.size(); j++)
+		{
+			auto& rhs = rhsBatch[j];
+			if (rhs.isCollidable() && lhs.collidesWith(&rhs))
+			{
+				onRacerExplodes(&lhs);
+				onRacerExplodes(&rhs);
+				m_explodedFlags[LhsIndex][i] = 1;
+				rhsExploded[j] = 1;
+			}
+		}
+	}
+
+	std::tuple<std::vector<RacerTypes>...> m_batches;
+	std::vector<uint8_t> m_explodedFlags[TypeCount]; // Reused between ticks to avoid reallocating
+};
+
+// Registry equivalent of updateRacersV2, keeping the same entry point for callers
+template <typename... RacerTypes>
+inline void updateRacersV2(float deltaTimeS, RacerRegistry<RacerTypes...>& racers)
+{
+	racers.update(deltaTimeS);
+}
@@ -0,0 +1,430 @@
+#pragma once
+
+#include "RacingGameExercise.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <vector>
+
+using RacerUpdateFunction = std::function<void(float, std::vector<Racer*>&)>;
+
+// Racer serialization used by recordings. The stub Racer only exposes its alive and collidable flags;
+//  any state added to Racer should be written and restored here so that replays reproduce it exactly
+inline void writeRacerState(const Racer& racer, std::vector<uint8_t>& out_data)
+{
+	uint8_t flags = (racer.isAlive() ? 1 : 0) | (racer.isCollidable() ? 2 : 0);
+	out_data.push_back(flags);
+}
+
+inline Racer* readRacerState(const uint8_t*& cursor, const uint8_t* end)
+{
+	if (cursor >= end)
+	{
+		return nullptr;
+	}
+	cursor++; // Flags are derived by the stub Racer itself, so there is nothing to restore
+	return new Racer();
+}
+
+inline bool skipRacerState(const uint8_t*& cursor, const uint8_t* end)
+{
+	if (cursor >= end)
+	{
+		return false;
+	}
+	cursor++;
+	return true;
+}
+
+namespace RacerRecordingFormat
+{
+
+static const uint32_t Magic = 0x43455252; // "RREC"
+static const uint8_t Version = 2;
+
+// Frame flags. A tick's time step and racer count are only written when they differ from the previous tick
+static const uint8_t HasStateHash = 1;
+static const uint8_t HasKeyframe = 2;
+static const uint8_t HasDeltaTimeChange = 4;
+static const uint8_t HasRacerCountChange = 8;
+
+inline void writeVarint(uint64_t value, std::vector<uint8_t>& out_data)
+{
+	while (value >= 0x80)
+	{
+		out_data.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out_data.push_back((uint8_t)value);
+}
+
+inline bool readVarint(const uint8_t*& cursor, const uint8_t* end, uint64_t& out_value)
+{
+	out_value = 0;
+	for (int shift = 0; cursor < end && shift < 64; shift += 7)
+	{
+		uint8_t byte = *cursor++;
+		out_value |= (uint64_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Zigzag encoding keeps small negative deltas, such as a few racers exploding, to a single byte
+inline uint64_t encodeSigned(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+inline int64_t decodeSigned(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+inline uint32_t floatToBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+inline float bitsToFloat(uint32_t bits)
+{
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// Order-dependent FNV-1a hash of every racer's serialized state, used to verify replays bit for bit
+inline uint64_t hashRacerStates(const std::vector<Racer*>& racers, std::vector<uint8_t>& scratch)
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (const auto* racer : racers)
+	{
+		scratch.clear();
+		writeRacerState(*racer, scratch);
+		for (uint8_t byte : scratch)
+		{
+			hash = (hash ^ byte) * 0x100000001B3ull;
+		}
+		hash = (hash ^ 0xFF) * 0x100000001B3ull; // Racer separator
+	}
+	return hash;
+}
+
+inline void writeKeyframe(const std::vector<Racer*>& racers, std::vector<uint8_t>& out_data)
+{
+	writeVarint(racers.size(), out_data);
+	for (const auto* racer : racers)
+	{
+		writeRacerState(*racer, out_data);
+	}
+}
+
+} // namespace RacerRecordingFormat
+
+// Records the starting racer collection and the input of every tick as compact binary frames.
+// Each frame is a flags byte followed only by what changed since the previous tick, so a tick at a steady frame rate
+//  in which no racer is removed costs one byte. An optional 8 byte state hash for verification, and a full keyframe
+//  at a fixed interval to allow seeking, are added on top
+class RacerTickRecorder
+{
+public:
+	explicit RacerTickRecorder(unsigned int keyframeInterval = 600, bool recordStateHashes = true) :
+		m_keyframeInterval(keyframeInterval),
+		m_recordStateHashes(recordStateHashes),
+		m_tickCount(0),
+		m_previousDeltaBits(0),
+		m_previousRacerCount(0)
+	{
+	}
+
+	void beginRecording(const std::vector<Racer*>& racers)
+	{
+		using namespace RacerRecordingFormat;
+		m_data.clear();
+		m_tickCount = 0;
+		m_previousDeltaBits = 0;
+		m_previousRacerCount = racers.size();
+
+		for (int i = 0; i < 4; i++)
+		{
+			m_data.push_back((uint8_t)(Magic >> (i * 8)));
+		}
+		m_data.push_back(Version);
+		writeVarint(m_keyframeInterval, m_data);
+		writeKeyframe(racers, m_data);
+	}
+
+	// Records a tick once it has been run; 'racers' is the collection after the update
+	void recordTick(float deltaTimeS, const std::vector<Racer*>& racers)
+	{
+		using namespace RacerRecordingFormat;
+		m_tickCount++;
+		bool isKeyframe = (m_keyframeInterval > 0 && m_tickCount % m_keyframeInterval == 0);
+		uint32_t deltaBitsChange = floatToBits(deltaTimeS) ^ m_previousDeltaBits;
+		int64_t racerCountChange = (int64_t)racers.size() - (int64_t)m_previousRacerCount;
+		uint8_t flags = (m_recordStateHashes ? HasStateHash : 0) | (isKeyframe ? HasKeyframe : 0)
+			| (deltaBitsChange != 0 ? HasDeltaTimeChange : 0) | (racerCountChange != 0 ? HasRacerCountChange : 0);
+		m_data.push_back(flags);
+
+		if (deltaBitsChange != 0)
+		{
+			writeVarint(deltaBitsChange, m_data);
+			m_previousDeltaBits ^= deltaBitsChange;
+		}
+		if (racerCountChange != 0)
+		{
+			writeVarint(encodeSigned(racerCountChange), m_data);
+			m_previousRacerCount = racers.size();
+		}
+
+		if (m_recordStateHashes)
+		{
+			uint64_t hash = hashRacerStates(racers, m_scratch);
+			for (int i = 0; i < 8; i++)
+			{
+				m_data.push_back((uint8_t)(hash >> (i * 8)));
+			}
+		}
+		if (isKeyframe)
+		{
+			writeKeyframe(racers, m_data);
+		}
+	}
+
+	void runAndRecordTick(float deltaTimeS, std::vector<Racer*>& racers, const RacerUpdateFunction& update)
+	{
+		update(deltaTimeS, racers);
+		recordTick(deltaTimeS, racers);
+	}
+
+	const std::vector<uint8_t>& getData() const { return m_data; }
+	size_t getTickCount() const { return m_tickCount; }
+
+	bool saveToFile(const char* path) const
+	{
+		FILE* file = fopen(path, "wb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+		bool success = (fwrite(m_data.data(), 1, m_data.size(), file) == m_data.size());
+		return (fclose(file) == 0) && success;
+	}
+
+private:
+	unsigned int m_keyframeInterval;
+	bool m_recordStateHashes;
+	size_t m_tickCount;
+	uint32_t m_previousDeltaBits;
+	size_t m_previousRacerCount;
+	std::vector<uint8_t> m_data;
+	std::vector<uint8_t> m_scratch;
+};
+
+struct ReplaySummary
+{
+	size_t ticksMeasured;
+	double totalMs;
+	double maxTickMs;
+	size_t mismatchedTicks; // Ticks whose racer count or state hash differs from the recording
+	long long firstMismatchedTick; // -1 when every tick matched
+};
+
+// Re-runs recorded ticks through any update implementation, for A/B timing and bit-exact verification
+class RacerTickReplay
+{
+public:
+	bool load(const std::vector<uint8_t>& data)
+	{
+		using namespace RacerRecordingFormat;
+		m_ticks.clear();
+		m_keyframes.clear();
+		m_data = data;
+
+		const uint8_t* cursor = m_data.data();
+		const uint8_t* end = cursor + m_data.size();
+		uint32_t magic = 0;
+		for (int i = 0; i < 4 && cursor < end; i++)
+		{
+			magic |= (uint32_t)(*cursor++) << (i * 8);
+		}
+		uint64_t keyframeInterval;
+		if (magic != Magic || cursor >= end || *cursor++ != Version || !readVarint(cursor, end, keyframeInterval))
+		{
+			return false;
+		}
+
+		uint64_t racerCount;
+		m_keyframes[0] = cursor - m_data.data();
+		if (!skipKeyframe(cursor, end, racerCount))
+		{
+			return false;
+		}
+
+		uint32_t deltaBits = 0;
+		while (cursor < end)
+		{
+			uint8_t flags = *cursor++;
+			uint64_t deltaXor = 0;
+			uint64_t countDelta = 0;
+			if (((flags & HasDeltaTimeChange) && !readVarint(cursor, end, deltaXor))
+				|| ((flags & HasRacerCountChange) && !readVarint(cursor, end, countDelta)))
+			{
+				return false;
+			}
+			deltaBits ^= (uint32_t)deltaXor;
+			racerCount += decodeSigned(countDelta);
+
+			RecordedTick tick;
+			tick.deltaTimeS = bitsToFloat(deltaBits);
+			tick.racerCount = (size_t)racerCount;
+			tick.hasStateHash = (flags & HasStateHash) != 0;
+			tick.stateHash = 0;
+			if (tick.hasStateHash)
+			{
+				if (end - cursor < 8)
+				{
+					return false;
+				}
+				for (int i = 0; i < 8; i++)
+				{
+					tick.stateHash |= (uint64_t)(*cursor++) << (i * 8);
+				}
+			}
+			m_ticks.push_back(tick);
+
+			if (flags & HasKeyframe)
+			{
+				// Keyframe holds the state after this tick, which is the starting state of the next
+				uint64_t keyframeCount;
+				m_keyframes[m_ticks.size()] = cursor - m_data.data();
+				if (!skipKeyframe(cursor, end, keyframeCount))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool loadFromFile(const char* path)
+	{
+		FILE* file = fopen(path, "rb");
+		if (file == nullptr)
+		{
+			return false;
+		}
+		std::vector<uint8_t> data;
+		uint8_t buffer[4096];
+		size_t bytesRead;
+		while ((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		{
+			data.insert(data.end(), buffer, buffer + bytesRead);
+		}
+		fclose(file);
+		return load(data);
+	}
+
+	size_t getTickCount() const { return m_ticks.size(); }
+
+	// Replays ticks [firstTick, lastTick) through 'update', measuring each one. Replay starts from the nearest
+	//  keyframe at or before firstTick; any ticks between the keyframe and firstTick are run but not measured
+	ReplaySummary replay(size_t firstTick, size_t lastTick, const RacerUpdateFunction& update)
+	{
+		using namespace RacerRecordingFormat;
+		using Clock = std::chrono::steady_clock;
+
+		ReplaySummary summary = {};
+		summary.firstMismatchedTick = -1;
+		lastTick = std::min(lastTick, m_ticks.size());
+		if (firstTick >= lastTick)
+		{
+			return summary;
+		}
+
+		auto keyframe = --m_keyframes.upper_bound(firstTick);
+		std::vector<Racer*> racers = restoreKeyframe(keyframe->second);
+		std::vector<uint8_t> scratch;
+		for (size_t tickIndex = keyframe->first; tickIndex < lastTick; tickIndex++)
+		{
+			const RecordedTick& tick = m_ticks[tickIndex];
+			auto start = Clock::now();
+			update(tick.deltaTimeS, racers);
+			double tickMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+			if (tickIndex >= firstTick)
+			{
+				summary.ticksMeasured++;
+				summary.totalMs += tickMs;
+				summary.maxTickMs = std::max(summary.maxTickMs, tickMs);
+
+				bool matches = (racers.size() == tick.racerCount);
+				if (matches && tick.hasStateHash)
+				{
+					matches = (hashRacerStates(racers, scratch) == tick.stateHash);
+				}
+				if (!matches)
+				{
+					summary.mismatchedTicks++;
+					if (summary.firstMismatchedTick < 0)
+					{
+						summary.firstMismatchedTick = (long long)tickIndex;
+					}
+				}
+			}
+		}
+
+		for (const auto* racer : racers)
+		{
+			delete racer;
+		}
+		return summary;
+	}
+
+private:
+	struct RecordedTick
+	{
+		float deltaTimeS;
+		size_t racerCount;
+		bool hasStateHash;
+		uint64_t stateHash;
+	};
+
+	static bool skipKeyframe(const uint8_t*& cursor, const uint8_t* end, uint64_t& out_racerCount)
+	{
+		if (!RacerRecordingFormat::readVarint(cursor, end, out_racerCount))
+		{
+			return false;
+		}
+		for (uint64_t i = 0; i < out_racerCount; i++)
+		{
+			if (!skipRacerState(cursor, end))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::vector<Racer*> restoreKeyframe(size_t offset) const
+	{
+		const uint8_t* cursor = m_data.data() + offset;
+		const uint8_t* end = m_data.data() + m_data.size();
+		uint64_t racerCount = 0;
+		RacerRecordingFormat::readVarint(cursor, end, racerCount);
+		std::vector<Racer*> racers;
+		racers.reserve((size_t)racerCount);
+		for (uint64_t i = 0; i < racerCount; i++)
+		{
+			racers.push_back(readRacerState(cursor, end));
+		}
+		return racers;
+	}
+
+	std::vector<uint8_t> m_data;
+	std::vector<RecordedTick> m_ticks;
+	std::map<size_t, size_t> m_keyframes; // Tick index to byte offset of the racer state at the start of that tick
+};
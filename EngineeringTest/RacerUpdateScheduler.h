@@ -0,0 +1,196 @@
+#pragma once
+
+#include "RacingGameExercise.h"
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// Replaces the update phase of updateRacersV2 with time-sliced updates. Each racer is placed in a priority
+//  tier, and tier N is only updated every m_tierIntervals[N] ticks, receiving all of the time accumulated since
+//  its previous update. Racers within a tier are given staggered phases, so each tick updates an even share of them.
+// Collision detection still runs every tick against every racer, as in updateRacersV2, but deferred racers are tested
+//  in their last updated state. Without a budget, a racer in tier N is at most m_tierIntervals[N] - 1 ticks behind when
+//  tested. Racers exposing no position cannot be extrapolated, so where a pair must be tested against current state,
+//  the PairSelector hook names the pairs whose racers are brought up to date first
+class RacerUpdateScheduler
+{
+public:
+	// Returns the tier for a racer, where zero is the most important. Evaluated when a racer is first seen and after each of its updates,
+	//  so racers approaching the player should be promoted in good time
+	using TierSelector = std::function<int(const Racer&)>;
+	// Returns true if both racers should be brought up to date before the pair is tested, such as when the game's
+	//  broadphase places them close together
+	using PairSelector = std::function<bool(const Racer&, const Racer&)>;
+
+	// tierIntervals[N] is the number of ticks between updates of tier N. Tier zero should normally have an interval of one.
+	// maxUpdatesPerTick caps the calls to Racer::update in a single tick, including those made to bring a selected pair up
+	//  to date; zero removes the cap. When more racers are due, those that have waited longest are updated first and the
+	//  rest are deferred to the next tick, so no racer is deferred indefinitely. Once the cap is reached, selected pairs
+	//  are tested in their last updated state
+	RacerUpdateScheduler(const std::vector<int>& tierIntervals, TierSelector tierSelector, size_t maxUpdatesPerTick = 0, PairSelector pairSelector = nullptr) :
+		m_tierIntervals(tierIntervals.empty() ? std::vector<int>(1, 1) : tierIntervals),
+		m_tierSelector(std::move(tierSelector)),
+		m_pairSelector(std::move(pairSelector)),
+		m_maxUpdatesPerTick(maxUpdatesPerTick),
+		m_updatesRemaining(0),
+		m_tickIndex(0)
+	{
+		for (auto& interval : m_tierIntervals)
+		{
+			interval = std::max(interval, 1);
+		}
+		m_nextPhaseForTier.assign(m_tierIntervals.size(), 0);
+	}
+
+	// RacerType may be Racer, or a type derived from it that hides its members, as with RacerRegistry
+	template <typename RacerType>
+	void update(float deltaTimeS, std::vector<RacerType*>& racers)
+	{
+		// Gather racers due this tick, looking each racer's state up once and keeping it alongside the racer
+		m_tickStates.clear();
+		m_dueStates.clear();
+		for (auto* racer : racers)
+		{
+			RacerState& state = findOrRegisterRacer(racer);
+			state.pendingTimeS += deltaTimeS;
+			state.isSelected = false;
+			m_tickStates.push_back(&state);
+			int interval = m_tierIntervals[state.tier];
+			if (state.isOverdue || (m_tickIndex + state.phase) % interval == 0)
+			{
+				m_dueStates.push_back(&state);
+			}
+		}
+
+		// When over budget, update the racers that have waited longest, then the most important, and defer the rest
+		size_t budget = m_dueStates.size();
+		if (m_maxUpdatesPerTick > 0)
+		{
+			budget = std::min(budget, m_maxUpdatesPerTick);
+		}
+		if (budget < m_dueStates.size())
+		{
+			std::stable_sort(m_dueStates.begin(), m_dueStates.end(), [](const RacerState* lhs, const RacerState* rhs)
+			{
+				return lhs->pendingTimeS > rhs->pendingTimeS || (lhs->pendingTimeS == rhs->pendingTimeS && lhs->tier < rhs->tier);
+			});
+		}
+		for (size_t i = 0; i < m_dueStates.size(); i++)
+		{
+			m_dueStates[i]->isSelected = (i < budget);
+			m_dueStates[i]->isOverdue = (i >= budget);
+		}
+		m_updatesRemaining = (m_maxUpdatesPerTick > 0) ? m_maxUpdatesPerTick - budget : (size_t)-1;
+
+		// Racers need to be updated in reverse order, matching updateRacersV2
+		for (size_t i = racers.size(); i-- > 0;)
+		{
+			if (m_tickStates[i]->isSelected)
+			{
+				updateRacer(*racers[i], *m_tickStates[i]);
+			}
+		}
+
+		// Exploded racers are deleted here, so their scheduling state must be dropped before the pointer can be reused
+		std::function<void(Racer*, Racer*)> beforePairTested;
+		if (m_pairSelector)
+		{
+			beforePairTested = [this](Racer* lhs, Racer* rhs)
+			{
+				if (m_pairSelector(*lhs, *rhs))
+				{
+					catchUpRacer(*static_cast<RacerType*>(lhs));
+					catchUpRacer(*static_cast<RacerType*>(rhs));
+				}
+			};
+		}
+		resolveRacerCollisions(racers, [this](Racer* racer)
+		{
+			m_racerStates.erase(racer);
+		}, beforePairTested);
+
+		m_tickIndex++;
+	}
+
+	// Racers removed from the collection by other code must be forgotten before they are deleted
+	void forgetRacer(const Racer* racer) { m_racerStates.erase(racer); }
+
+	size_t getTierCount() const { return m_tierIntervals.size(); }
+
+private:
+	struct RacerState
+	{
+		float pendingTimeS;
+		int tier;
+		int phase;
+		bool isOverdue; // Due on an earlier tick but deferred by the budget
+		bool isSelected;
+	};
+
+	RacerState& findOrRegisterRacer(const Racer* racer)
+	{
+		auto existing = m_racerStates.find(racer);
+		if (existing != m_racerStates.end())
+		{
+			return existing->second;
+		}
+
+		RacerState& state = m_racerStates[racer];
+		state.pendingTimeS = 0;
+		state.isOverdue = false;
+		state.isSelected = false;
+		state.tier = -1;
+		assignTier(*racer, state);
+		return state;
+	}
+
+	template <typename RacerType>
+	void updateRacer(RacerType& racer, RacerState& state)
+	{
+		if (racer.isAlive())
+		{
+			racer.update(state.pendingTimeS * 1000.0f);
+		}
+		state.pendingTimeS = 0;
+		state.isOverdue = false;
+		assignTier(racer, state);
+	}
+
+	// Gives a racer its pending time ahead of a collision test, if it has any and the budget allows
+	template <typename RacerType>
+	void catchUpRacer(RacerType& racer)
+	{
+		RacerState& state = m_racerStates[&racer];
+		if (state.pendingTimeS > 0 && m_updatesRemaining > 0)
+		{
+			m_updatesRemaining--;
+			updateRacer(racer, state);
+		}
+	}
+
+	void assignTier(const Racer& racer, RacerState& state)
+	{
+		int tier = std::min(std::max(m_tierSelector ? m_tierSelector(racer) : 0, 0), (int)m_tierIntervals.size() - 1);
+		if (tier != state.tier)
+		{
+			// Round-robin phases spread each tier evenly across its interval
+			state.tier = tier;
+			state.phase = m_nextPhaseForTier[tier];
+			m_nextPhaseForTier[tier] = (m_nextPhaseForTier[tier] + 1) % m_tierIntervals[tier];
+		}
+	}
+
+	std::vector<int> m_tierIntervals;
+	TierSelector m_tierSelector;
+	PairSelector m_pairSelector;
+	size_t m_maxUpdatesPerTick;
+	size_t m_updatesRemaining; // Updates left in this tick's budget for bringing selected pairs up to date
+	unsigned int m_tickIndex;
+	std::vector<int> m_nextPhaseForTier;
+	std::unordered_map<const Racer*, RacerState> m_racerStates;
+	// Reused between ticks to avoid reallocating. Node-based map entries keep their addresses as other racers are added
+	std::vector<RacerState*> m_tickStates;
+	std::vector<RacerState*> m_dueStates;
+};
@@ -1,11 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
+#include <set>
 #include <vector>
 
-namespace
-{
-
-// Added stub implementation to allow compilation
+// Added stub implementation to allow compilation. Declared with external linkage, so classes in other headers
+//  can hold Racer types without each translation unit seeing a different Racer
 class Racer
 {
 public:
@@ -15,9 +16,7 @@ public:
 	void update(float deltaTimeMS) {}
 };
 
-void onRacerExplodes(Racer* racer) {}
-
-} // namespace
+inline void onRacerExplodes(Racer* racer) {}
 
 inline std::vector<Racer*> createRacerCollection(int count)
 {
@@ -96,21 +95,30 @@ inline void updateRacers(float deltaTimeS, std::vector<Racer*>& racers)
 	}
 }
 
-inline void updateRacersV2(float deltaTimeS, std::vector<Racer*>& racers)
+// onRacerRemoved is called for each exploded racer immediately before it is deleted
+template <typename RacerType>
+inline void removeExplodedRacers(const std::set<int>& entriesToRemove, std::vector<RacerType*>& racers, const std::function<void(Racer*)>& onRacerRemoved)
 {
-	// TODO: Choose consistent time format
-	float racerUpdateTick = deltaTimeS * 1000.0f;
-
-	// Racers need to be updated in reverse order. TODO: Investigate importance of ordering
-	for (auto it = racers.rbegin(); it != racers.rend(); ++it)
+	// Get rid of all the exploded racers. Work in reverse order to maintain iterators and minimise shuffling of memory
+	for (auto it = entriesToRemove.crbegin(); it != entriesToRemove.crend(); it++)
 	{
-		auto* racer = *it;
-		if (racer->isAlive())
+		if (onRacerRemoved)
 		{
-			racer->update(racerUpdateTick);
+			onRacerRemoved(racers[*it]);
 		}
+		delete racers[*it];
+		racers.erase(racers.begin() + *it);
 	}
+}
 
+// Collision and removal phase of updateRacersV2, shared with other update strategies. RacerType may be any type
+//  derived from Racer that hides its members, such as those stored in a RacerRegistry.
+// onRacerRemoved is called for each exploded racer immediately before it is deleted. beforePairTested is called
+//  with each pair of collidable racers before collidesWith, so a caller can bring deferred racers up to date
+template <typename RacerType>
+inline void resolveRacerCollisions(std::vector<RacerType*>& racers, const std::function<void(Racer*)>& onRacerRemoved = nullptr,
+	const std::function<void(Racer*, Racer*)>& beforePairTested = nullptr)
+{
 	std::set<int> entriesToRemove;
 	// Already empty on construction, no need to call clear()
 
@@ -118,14 +126,18 @@ inline void updateRacersV2(float deltaTimeS, std::vector<Racer*>& racers)
 	size_t racersCount = racers.size();
 	for (size_t i = 0; i < racersCount; i++)
 	{
-		Racer* lhs = racers[i]; // Micro-optimization, retrieve racer once here
+		RacerType* lhs = racers[i]; // Micro-optimization, retrieve racer once here
 		if (lhs->isCollidable())
 		{
 			bool lhsHasCollided = false;
 			// Begin at it1 + 1, reduce loop from O(n^2) to O(n*(n-1)/2)
-			for (size_t j = i + i; j < racersCount; j++)
+			for (size_t j = i + 1; j < racersCount; j++)
 			{
-				Racer* rhs = racers[j];
+				RacerType* rhs = racers[j];
+				if (beforePairTested && rhs->isCollidable())
+				{
+					beforePairTested(lhs, rhs);
+				}
 				if (rhs->isCollidable() && lhs->collidesWith(rhs))
 				{
 					onRacerExplodes(lhs);
@@ -145,12 +157,31 @@ inline void updateRacersV2(float deltaTimeS, std::vector<Racer*>& racers)
 		}
 	}
 
-	// Get rid of all the exploded racers. Work in reverse order to maintain iterators and minimise shuffling of memory
-	for (auto it = entriesToRemove.crbegin(); it != entriesToRemove.crend(); it++)
+	removeExplodedRacers(entriesToRemove, racers, onRacerRemoved);
+}
+
+// Update phase of updateRacersV2, shared with other update strategies
+template <typename RacerType>
+inline void updateLiveRacers(float deltaTimeS, std::vector<RacerType*>& racers)
+{
+	// TODO: Choose consistent time format
+	float racerUpdateTick = deltaTimeS * 1000.0f;
+
+	// Racers need to be updated in reverse order. TODO: Investigate importance of ordering
+	for (auto it = racers.rbegin(); it != racers.rend(); ++it)
 	{
-		delete racers[*it];
-		racers.erase(racers.begin() + *it);
+		auto* racer = *it;
+		if (racer->isAlive())
+		{
+			racer->update(racerUpdateTick);
+		}
 	}
+}
+
+inline void updateRacersV2(float deltaTimeS, std::vector<Racer*>& racers)
+{
+	updateLiveRacers(deltaTimeS, racers);
+	resolveRacerCollisions(racers);
 
 	// newRacerList ultimately had no effect on the list of racers, as entries were removed in-place and no reordering occurred.
 }
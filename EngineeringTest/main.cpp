@@ -1,12 +1,20 @@
 #include "WindowsConsoleRenderer.h"
 
 #include "BallGameExercise.h"
+#include "MatchingGameBatch.h"
 #include "MatchingGameExercise.h"
 #include "RacingGameExercise.h"
 
 #include <chrono>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 
 using Clock = std::chrono::steady_clock;
 
@@ -19,8 +27,101 @@ void runRacerTest(float updateTick, std::vector<Racer*>& racers, std::function<v
 	printf("\nTime taken: %lldms, racers remaining: %d\n", diff.count(), racers.size());
 }
 
+void printBatchUsage()
+{
+	fprintf(stderr, "Usage: EngineeringTest --batch [options]\n");
+	fprintf(stderr, "  --input FILE          Read boards from FILE instead of stdin\n");
+	fprintf(stderr, "  --binary              Read boards in the binary format instead of text\n");
+	fprintf(stderr, "  --threads N           Worker threads, zero for all hardware threads\n");
+	fprintf(stderr, "  --batch-size N        Boards evaluated together by a single worker\n");
+}
+
+// Headless mode: streams boards in and writes the best move for each to stdout, without the demos or console rendering
+int runBatchMode(int argc, char** argv)
+{
+	BatchConfig config;
+	const char* inputPath = nullptr;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = (i + 1 < argc);
+		if (strcmp(argv[i], "--batch") == 0)
+		{
+			continue;
+		}
+		else if (strcmp(argv[i], "--input") == 0 && hasValue)
+		{
+			inputPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--binary") == 0)
+		{
+			config.inputFormat = BoardStreamFormat::Binary;
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+		{
+			config.threadCount = (unsigned int)strtoul(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--batch-size") == 0 && hasValue)
+		{
+			config.batchSize = atoi(argv[++i]);
+		}
+		else
+		{
+			printBatchUsage();
+			return 1;
+		}
+	}
+
+	bool isBinary = (config.inputFormat == BoardStreamFormat::Binary);
+	FILE* input = stdin;
+	if (inputPath != nullptr)
+	{
+		input = fopen(inputPath, isBinary ? "rb" : "r");
+		if (input == nullptr)
+		{
+			fprintf(stderr, "Unable to open '%s'\n", inputPath);
+			return 1;
+		}
+	}
+#ifdef _WIN32
+	else if (isBinary)
+	{
+		_setmode(_fileno(stdin), _O_BINARY);
+	}
+#endif
+
+	// Results go to stdout; the summary and any errors go to stderr
+	int exitCode = 0;
+	try
+	{
+		MatchingBatchProcessor processor(config);
+		BatchStats stats = processor.run(input, stdout);
+		fprintf(stderr, "Processed %lld boards (%lld without moves) in %.3fs, %.1f boards/s\n", stats.boardsProcessed, stats.boardsWithoutMoves, stats.elapsedS, stats.boardsPerSecond);
+	}
+	catch (const std::exception& error)
+	{
+		fprintf(stderr, "Error: %s\n", error.what());
+		exitCode = 1;
+	}
+
+	if (input != stdin)
+	{
+		fclose(input);
+	}
+	return exitCode;
+}
+
 int main(int argc, char** argv)
 {
+	if (argc > 1)
+	{
+		if (strcmp(argv[1], "--batch") == 0)
+		{
+			return runBatchMode(argc, argv);
+		}
+		printBatchUsage();
+		return 1;
+	}
+
 	srand(1);
 
 	// ==========
@@ -95,6 +196,20 @@ int main(int argc, char** argv)
 	{
 		printf("\nPath does not intersect with line 'h'.\n");
 	}
+
+	// The same ball can answer further queries without repeating its setup
+	BallTrajectory trajectory(startPoint, startVelocity, gravity, boundsWidth);
+	HeightCrossings crossings = trajectory.calculateCrossingsAtHeight(targetHeight);
+	for (int i = 0; i < crossings.count; i++)
+	{
+		const auto& crossing = crossings.crossings[i];
+		printf("Crosses line 'h' %s at t=%g, x=%g\n", crossing.isRising ? "rising" : "falling", crossing.t, crossing.x);
+	}
+	float lastCrossingTime = (crossings.count > 0) ? crossings.crossings[crossings.count - 1].t : 0.0f;
+	for (const auto& bounce : trajectory.calculateWallBounces(lastCrossingTime))
+	{
+		printf("Bounces off wall at t=%g, [x:%g y:%g]\n", bounce.t, bounce.position.x, bounce.position.y);
+	}
 	printf("Start point 'o', end point 'x':\n");
 	renderer.printGraphWithPathAndTargetHeight(targetHeight, startPoint, startVelocity, gravity, boundsWidth);
 